@@ -0,0 +1,46 @@
+#pragma once
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <exception>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace asio = boost::asio;
+
+// Benchmarks that need a server read its connection URI from the environment, they are skipped if it isn't set.
+inline std::optional<std::string> benchmark_conninfo(benchmark::State& state)
+{
+  if (const auto* conninfo = std::getenv("PSQL_BENCHMARK_CONNINFO"))
+    return conninfo;
+
+  state.SkipWithError("PSQL_BENCHMARK_CONNINFO is not set");
+  return std::nullopt;
+}
+
+// Runs the context until all spawned operations are completed, rethrows the first exception if any.
+inline void run(asio::io_context& ioc, std::exception_ptr& ep)
+{
+  ioc.restart();
+  ioc.run();
+  if (ep)
+    std::rethrow_exception(std::exchange(ep, nullptr));
+}
+
+template<typename Awaitable>
+void spawn(asio::io_context& ioc, std::exception_ptr& ep, Awaitable awaitable)
+{
+  asio::co_spawn(
+    ioc,
+    std::move(awaitable),
+    [&ep](std::exception_ptr e, auto&&...)
+    {
+      if (e && !ep)
+        ep = e;
+    });
+}
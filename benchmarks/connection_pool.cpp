@@ -0,0 +1,59 @@
+#include "common.hpp"
+
+#include <psql/connection_pool.hpp>
+#include <psql/sharded_connection_pool.hpp>
+
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/use_future.hpp>
+
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr size_t max_size = 64;
+
+// Measures aquiring an idle connection and returning it, with every benchmark thread competing for the same pool.
+template<typename Pool>
+void aquire_and_return(benchmark::State& state)
+{
+  static auto workers = std::optional<asio::thread_pool>{};
+  static auto pool    = std::optional<Pool>{};
+
+  auto conninfo = benchmark_conninfo(state);
+  if (!conninfo)
+    return;
+
+  if (state.thread_index() == 0)
+  {
+    workers.emplace(std::thread::hardware_concurrency());
+    pool.emplace(workers->get_executor(), *conninfo, max_size);
+
+    // Opens all connections up front, so the measured loop only hands out idle ones.
+    auto conns = std::vector<decltype(pool->async_aquire(asio::use_future))>{};
+    for (size_t i = 0; i < max_size; i++)
+      conns.push_back(pool->async_aquire(asio::use_future));
+    for (auto& conn : conns)
+      conn.get();
+  }
+
+  for (auto _ : state)
+  {
+    auto conn = pool->async_aquire(asio::use_future).get();
+    benchmark::DoNotOptimize(conn);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0)
+  {
+    pool.reset();
+    workers->join();
+    workers.reset();
+  }
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(aquire_and_return, psql::connection_pool)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(aquire_and_return, psql::sharded_connection_pool)->ThreadRange(1, 64)->UseRealTime();
@@ -0,0 +1,157 @@
+#include <psql/detail/serialization.hpp>
+#include <psql/result.hpp>
+#include <psql/row_mapper.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+// Builds a result in binary format without a server, every row holding the same serialized parameters.
+template<typename... Ts>
+psql::result make_result(size_t rows, const psql::params<Ts...>& params)
+{
+  auto omp    = psql::detail::oid_map{};
+  auto buffer = std::string{};
+  auto [types, values, lengths, formats] = psql::detail::serialize(omp, buffer, params);
+
+  auto names = std::vector<std::string>{};
+  auto attrs = std::vector<PGresAttDesc>{};
+  for (size_t i = 0; i < sizeof...(Ts); i++)
+  {
+    names.push_back("f" + std::to_string(i));
+    attrs.push_back({ names.back().data(), 0, 0, 1, types[i], -1, -1 });
+  }
+
+  auto* pg_result = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+  PQsetResultAttrs(pg_result, attrs.size(), attrs.data());
+  for (size_t r = 0; r < rows; r++)
+    for (size_t i = 0; i < sizeof...(Ts); i++)
+      PQsetvalue(pg_result, r, i, const_cast<char*>(values[i]), lengths[i]);
+
+  return psql::result{ pg_result };
+}
+
+struct trade
+{
+  int64_t id;
+  double price;
+  std::string_view symbol;
+};
+
+const auto trade_params = psql::mp(int64_t{ 42 }, 3.14, std::string_view{ "PSQL" });
+
+void decode_rows_with_as(benchmark::State& state)
+{
+  const auto result = make_result(state.range(0), trade_params);
+
+  for (auto _ : state)
+    for (const auto row : result)
+      benchmark::DoNotOptimize(as<int64_t, double, std::string_view>(row));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void decode_rows_with_row_mapper(benchmark::State& state)
+{
+  const auto result = make_result(state.range(0), trade_params);
+  auto mapper       = psql::row_mapper<trade>{};
+  if (mapper.bind(result))
+    return state.SkipWithError("Failed to bind the row mapper");
+
+  for (auto _ : state)
+    for (const auto row : result)
+      benchmark::DoNotOptimize(mapper(row));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void decode_columns(benchmark::State& state)
+{
+  const auto result = make_result(state.range(0), trade_params);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(result.columns<int64_t, double, std::string_view>());
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void decode_int_array(benchmark::State& state)
+{
+  const auto result = make_result(1, psql::mp(std::vector<int32_t>(state.range(0), 42)));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(as<std::vector<int32_t>>(result));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void decode_int_array_view(benchmark::State& state)
+{
+  const auto result = make_result(1, psql::mp(std::vector<int32_t>(state.range(0), 42)));
+
+  for (auto _ : state)
+  {
+    auto sum = int64_t{};
+    for (auto value : as<psql::array_view<int32_t>>(result))
+      sum += value;
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void decode_text_array(benchmark::State& state)
+{
+  const auto result = make_result(1, psql::mp(std::vector<std::string>(state.range(0), std::string(16, 'x'))));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(as<std::vector<std::string>>(result));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void decode_text_array_view(benchmark::State& state)
+{
+  const auto result = make_result(1, psql::mp(std::vector<std::string>(state.range(0), std::string(16, 'x'))));
+
+  for (auto _ : state)
+  {
+    auto size = size_t{};
+    for (auto value : as<psql::array_view<std::string_view>>(result))
+      size += value.size();
+    benchmark::DoNotOptimize(size);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void decode_composite(benchmark::State& state)
+{
+  const auto result = make_result(1, psql::mp(std::tuple{ int64_t{ 42 }, std::string(16, 'x'), 3.14 }));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(as<std::tuple<int64_t, std::string, double>>(result));
+}
+
+void decode_composite_view(benchmark::State& state)
+{
+  const auto result = make_result(1, psql::mp(std::tuple{ int64_t{ 42 }, std::string(16, 'x'), 3.14 }));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(as<psql::composite_view<int64_t, std::string_view, double>>(result).get<1>());
+}
+} // namespace
+
+BENCHMARK(decode_rows_with_as)->RangeMultiplier(32)->Range(32, 1 << 20);
+BENCHMARK(decode_rows_with_row_mapper)->RangeMultiplier(32)->Range(32, 1 << 20);
+BENCHMARK(decode_columns)->RangeMultiplier(32)->Range(32, 1 << 20);
+BENCHMARK(decode_int_array)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(decode_int_array_view)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(decode_text_array)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(decode_text_array_view)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(decode_composite);
+BENCHMARK(decode_composite_view);
@@ -0,0 +1,97 @@
+#include "common.hpp"
+
+#include <psql/connection.hpp>
+
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace
+{
+constexpr auto query = "SELECT $1::INT8;";
+
+// Connects before the measured loop, returns false if the benchmark was skipped.
+bool connect(benchmark::State& state, asio::io_context& ioc, psql::connection& conn)
+{
+  auto conninfo = benchmark_conninfo(state);
+  if (!conninfo)
+    return false;
+
+  auto ep = std::exception_ptr{};
+  spawn(ioc, ep, conn.async_connect(*conninfo, asio::use_awaitable));
+  run(ioc, ep);
+  return true;
+}
+
+// Each query waits for the result of the previous one.
+void sequential_queries(benchmark::State& state)
+{
+  auto ioc  = asio::io_context{};
+  auto conn = psql::connection{ ioc };
+  if (!connect(state, ioc, conn))
+    return;
+
+  auto ep    = std::exception_ptr{};
+  auto batch = [&]() -> asio::awaitable<void>
+  {
+    for (int64_t i = 0; i < state.range(0); i++)
+      co_await conn.async_query(query, psql::mp(i), asio::deferred);
+  };
+
+  for (auto _ : state)
+  {
+    spawn(ioc, ep, batch());
+    run(ioc, ep);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// All queries are sent in a single pipeline with one sync point.
+void pipelined_queries(benchmark::State& state)
+{
+  auto ioc  = asio::io_context{};
+  auto conn = psql::connection{ ioc };
+  if (!connect(state, ioc, conn))
+    return;
+
+  auto ep       = std::exception_ptr{};
+  auto pipeline = [&](psql::pipeline& p)
+  {
+    for (int64_t i = 0; i < state.range(0); i++)
+      p.push_query(query, psql::mp(i));
+  };
+
+  for (auto _ : state)
+  {
+    spawn(ioc, ep, conn.async_exec_pipeline(pipeline, asio::use_awaitable));
+    run(ioc, ep);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Concurrent queries are coalesced into pipelines, each query with its own sync point.
+void auto_pipelined_queries(benchmark::State& state)
+{
+  auto ioc  = asio::io_context{};
+  auto conn = psql::connection{ ioc };
+  if (!connect(state, ioc, conn))
+    return;
+
+  conn.auto_pipelining(true);
+
+  auto ep = std::exception_ptr{};
+  for (auto _ : state)
+  {
+    for (int64_t i = 0; i < state.range(0); i++)
+      spawn(ioc, ep, conn.async_query(query, psql::mp(i), asio::use_awaitable));
+    run(ioc, ep);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+} // namespace
+
+BENCHMARK(sequential_queries)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+BENCHMARK(pipelined_queries)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+BENCHMARK(auto_pipelined_queries)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
@@ -0,0 +1,114 @@
+#include <psql/detail/serialization.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+struct employee
+{
+  std::string name;
+  int64_t id;
+  std::vector<int32_t> scores;
+};
+} // namespace
+
+template<>
+struct psql::user_defined<employee>
+{
+  static constexpr auto name = "employee";
+};
+
+namespace
+{
+using element_type = std::tuple<int64_t, std::string, std::vector<int32_t>>;
+
+std::vector<element_type> make_nested_arrays(size_t size)
+{
+  auto result = std::vector<element_type>{};
+  for (size_t i = 0; i < size; i++)
+    result.emplace_back(i, std::string(16, 'x'), std::vector<int32_t>(8, 42));
+  return result;
+}
+
+template<typename... Ts>
+void serialize_params(benchmark::State& state, const psql::detail::oid_map& omp, const psql::params<Ts...>& params)
+{
+  auto buffer = std::string{};
+
+  for (auto _ : state)
+  {
+    auto result = psql::detail::serialize(omp, buffer, params);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+void serialize_scalars(benchmark::State& state)
+{
+  serialize_params(state, {}, psql::mp(int16_t{ 1 }, int32_t{ 2 }, int64_t{ 3 }, 4.0f, 5.0, true));
+}
+
+void serialize_strings(benchmark::State& state)
+{
+  const auto params = psql::mp(std::string(state.range(0), 'x'), std::string(state.range(0), 'y'), int64_t{ 42 });
+  serialize_params(state, {}, params);
+}
+
+void serialize_int_array(benchmark::State& state)
+{
+  serialize_params(state, {}, psql::mp(std::vector<int32_t>(state.range(0), 42)));
+}
+
+void serialize_text_array(benchmark::State& state)
+{
+  serialize_params(state, {}, psql::mp(std::vector<std::string>(state.range(0), std::string(16, 'x'))));
+}
+
+void serialize_nested_arrays(benchmark::State& state)
+{
+  serialize_params(state, {}, psql::mp(make_nested_arrays(state.range(0))));
+}
+
+void serialize_user_defined(benchmark::State& state)
+{
+  auto omp = psql::detail::oid_map{};
+  omp.emplace(psql::detail::udt_slot<employee>(), { 100000, 100001 });
+
+  const auto employees = std::vector<employee>(state.range(0), employee{ std::string(16, 'x'), 42, { 1, 2, 3 } });
+  serialize_params(state, omp, psql::mp(employees));
+}
+
+// The walk the serializer used to perform up front for sizing the buffer, and again for the length of every nested
+// value; the single pass serializer doesn't need it anymore.
+void size_of_nested_arrays(benchmark::State& state)
+{
+  const auto arrays = make_nested_arrays(state.range(0));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(psql::detail::size_of(arrays));
+}
+
+void oid_of_user_defined(benchmark::State& state)
+{
+  auto omp = psql::detail::oid_map{};
+  omp.emplace(psql::detail::udt_slot<employee>(), { 100000, 100001 });
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(omp);
+    benchmark::DoNotOptimize(psql::detail::oid_of<std::vector<employee>>(omp));
+  }
+}
+} // namespace
+
+BENCHMARK(serialize_scalars);
+BENCHMARK(serialize_strings)->RangeMultiplier(64)->Range(64, 1 << 24);
+BENCHMARK(serialize_int_array)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(serialize_text_array)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(serialize_nested_arrays)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(serialize_user_defined)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(size_of_nested_arrays)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(oid_of_user_defined);
@@ -0,0 +1,36 @@
+#include <psql/connection.hpp>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/experimental/promise.hpp>
+#include <boost/asio/experimental/use_promise.hpp>
+
+#include <iostream>
+
+namespace asio = boost::asio;
+
+asio::awaitable<void> lookup(psql::connection& conn, int id)
+{
+  // Concurrent queries on the same connection are sent back-to-back without waiting for the previous results.
+  auto result = co_await conn.async_query("SELECT $1::INT * 2;", psql::mp(id), asio::deferred);
+  std::cout << id << " * 2 = " << as<int>(result) << std::endl;
+}
+
+asio::awaitable<void> async_main(std::string conninfo)
+{
+  auto exec = co_await asio::this_coro::executor;
+  auto conn = psql::connection{ exec };
+
+  co_await conn.async_connect(conninfo, asio::deferred);
+
+  // Each query still has its own sync point, so a failing query doesn't affect the others.
+  conn.auto_pipelining(true);
+
+  auto lookups = std::vector<asio::experimental::promise<void(std::exception_ptr)>>{};
+  for (auto i = 0; i < 16; i++)
+    lookups.push_back(asio::co_spawn(exec, lookup(conn, i), asio::experimental::use_promise));
+
+  for (auto& lookup : lookups)
+    co_await lookup(asio::deferred);
+}
@@ -0,0 +1,50 @@
+#include <psql/connection.hpp>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/deferred.hpp>
+
+#include <iostream>
+
+namespace asio = boost::asio;
+
+struct Event
+{
+  std::int64_t id;
+  std::string name;
+  std::vector<std::int32_t> tags;
+};
+
+asio::awaitable<void> async_main(std::string conninfo)
+{
+  auto exec = co_await asio::this_coro::executor;
+  auto conn = psql::connection{ exec };
+
+  co_await conn.async_connect(conninfo, asio::deferred);
+
+  co_await conn.async_query("DROP TABLE IF EXISTS events;", asio::deferred);
+  co_await conn.async_query("CREATE TABLE events (id INT8, name TEXT, tags INT4[]);", asio::deferred);
+
+  // Rows can be aggregates or tuples, their fields are serialized in the order of the columns in the COPY query.
+  auto events = std::vector<Event>{};
+  for (auto i = 0; i < 100000; i++)
+    events.push_back({ i, "event-" + std::to_string(i), { i % 3, i % 5 } });
+
+  // The vector must outlive the operation, rows are serialized and sent in large chunks.
+  auto result = co_await conn.async_copy_in("COPY events FROM STDIN (FORMAT BINARY);", events, asio::deferred);
+  std::cout << "copied rows:" << PQcmdTuples(result.native_handle()) << std::endl;
+
+  // Tuples are decoded directly from the received COPY data, std::string_view fields are valid only until the handler
+  // returns.
+  auto tags_sum = int64_t{};
+  co_await conn.async_copy_out<std::tuple<std::int64_t, std::string_view, std::vector<std::int32_t>>>(
+    "COPY (SELECT * FROM events WHERE id < 10) TO STDOUT (FORMAT BINARY);",
+    [&](auto row)
+    {
+      const auto& [id, name, tags] = row;
+      std::cout << id << ":" << name << std::endl;
+      for (auto tag : tags)
+        tags_sum += tag;
+    },
+    asio::deferred);
+  std::cout << "tags sum:" << tags_sum << std::endl;
+}
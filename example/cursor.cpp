@@ -0,0 +1,53 @@
+#include <psql/cursor.hpp>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <iostream>
+
+namespace asio = boost::asio;
+
+asio::awaitable<void> async_main(std::string conninfo)
+{
+  auto exec = co_await asio::this_coro::executor;
+  auto conn = psql::connection{ exec };
+
+  co_await conn.async_connect(conninfo, asio::deferred);
+
+  co_await conn.async_query("DROP TABLE IF EXISTS events;", asio::deferred);
+  co_await conn.async_query(
+    "CREATE TABLE events AS SELECT i AS id, 'event-' || i AS name FROM generate_series(1, 100000) AS i;",
+    asio::deferred);
+
+  // A cursor declared without with_hold lives within a transaction block.
+  co_await conn.async_query("BEGIN;", asio::deferred);
+
+  // Batches are sized to take about 64 KiB each, after the width of the rows in the first one.
+  auto cursor = psql::cursor{ conn, "events_cursor", { .target_batch_bytes = 64 * 1024 } };
+  co_await cursor.async_declare("SELECT id, name FROM events WHERE id % $1 = 0", psql::mp(2), asio::deferred);
+
+  auto timer    = asio::steady_timer{ exec };
+  auto num_rows = size_t{};
+  for (auto i = 0; i < 5 && !cursor.is_exhausted(); i++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    auto batch = co_await cursor.async_fetch(asio::deferred);
+    std::cout << "batch:" << batch.size() << " rows in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()
+              << "us, next batch:" << cursor.batch_size() << " rows" << std::endl;
+
+    num_rows += batch.size();
+
+    // Simulates processing the batch. The next FETCH is already on its way meanwhile, so the next async_fetch
+    // completes without waiting for a round trip.
+    timer.expires_after(std::chrono::milliseconds{ 20 });
+    co_await timer.async_wait(asio::deferred);
+  }
+  std::cout << "processed rows:" << num_rows << std::endl;
+
+  // Stops early. The prefetched batch is discarded, then the cursor is closed on the server.
+  co_await cursor.async_close(asio::deferred);
+
+  co_await conn.async_query("COMMIT;", asio::deferred);
+}
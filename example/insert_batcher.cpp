@@ -0,0 +1,63 @@
+#include <psql/insert_batcher.hpp>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/experimental/promise.hpp>
+#include <boost/asio/experimental/use_promise.hpp>
+
+#include <iostream>
+
+namespace asio = boost::asio;
+
+struct Event
+{
+  std::int64_t user_id;
+  std::string kind;
+};
+
+asio::awaitable<void> async_main(std::string conninfo)
+{
+  auto exec      = co_await asio::this_coro::executor;
+  auto conn_pool = psql::connection_pool{ exec, conninfo, 4 };
+
+  {
+    auto conn = co_await conn_pool.async_aquire(asio::deferred);
+    co_await conn->async_query("DROP TABLE IF EXISTS events;", asio::deferred);
+    co_await conn->async_query("CREATE TABLE events (user_id INT8, kind TEXT);", asio::deferred);
+  }
+
+  auto options           = psql::insert_batcher_options{};
+  options.max_batch_rows = 100;
+  options.max_delay      = std::chrono::milliseconds{ 50 };
+
+  auto batcher = psql::insert_batcher<Event>{ conn_pool, "COPY events FROM STDIN (FORMAT BINARY);", options };
+
+  // 250 concurrent inserts fill two batches, which are flushed as soon as they are full. The remaining 50 rows are
+  // flushed once the first of them has waited for max_delay.
+  // Each insert completes once the batch of its row has been committed.
+  auto inserts = std::vector<asio::experimental::promise<void(boost::system::error_code)>>{};
+  for (auto i = 0; i < 250; i++)
+    inserts.push_back(batcher.async_insert({ i, "login" }, asio::experimental::use_promise));
+
+  for (auto& insert : inserts)
+    co_await insert(asio::deferred);
+
+  // A lone row waits for max_delay, unless the batch is flushed explicitly.
+  auto start = std::chrono::steady_clock::now();
+  co_await batcher.async_insert({ 250, "logout" }, asio::deferred);
+  std::cout << "lone insert took:"
+            << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+            << "ms" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  auto flushed = batcher.async_insert({ 251, "logout" }, asio::experimental::use_promise);
+  batcher.flush();
+  co_await flushed(asio::deferred);
+  std::cout << "flushed insert took:"
+            << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+            << "ms" << std::endl;
+
+  auto conn  = co_await conn_pool.async_aquire(asio::deferred);
+  auto count = co_await conn->async_query("SELECT count(*) FROM events;", asio::deferred);
+  std::cout << "inserted rows:" << as<int64_t>(count) << std::endl;
+}
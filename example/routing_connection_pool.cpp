@@ -0,0 +1,58 @@
+#include <psql/routing_connection_pool.hpp>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/deferred.hpp>
+
+#include <iostream>
+
+namespace asio = boost::asio;
+
+void print_status(const psql::routing_connection_pool& conn_pool)
+{
+  for (size_t i = 0; i < conn_pool.num_hosts(); i++)
+  {
+    auto status = conn_pool.status(i);
+    std::cout << "host " << i << ": "
+              << (status.is_primary ? (*status.is_primary ? "primary" : "replica") : "unknown role") << ", "
+              << (status.is_available ? "available" : "unavailable") << ", latency:"
+              << std::chrono::duration_cast<std::chrono::microseconds>(status.latency).count() << "us" << std::endl;
+  }
+}
+
+asio::awaitable<void> async_main(std::string conninfo)
+{
+  auto exec = co_await asio::this_coro::executor;
+
+  auto options                  = psql::routing_options{};
+  options.health_check_interval = std::chrono::seconds{ 1 };
+  options.failure_backoff       = std::chrono::seconds{ 3 };
+  options.probe_timeout         = std::chrono::milliseconds{ 500 };
+
+  // The second host stands in for a replica that is down, nothing listens on its port.
+  auto conn_pool =
+    psql::routing_connection_pool{ exec, { conninfo, "host=127.0.0.1 port=1 connect_timeout=1" }, 4, options };
+
+  // Writes wait until the primary has answered its first probe.
+  {
+    auto conn = co_await conn_pool.async_aquire(psql::access_mode::read_write, asio::deferred);
+    co_await conn->async_query("DROP TABLE IF EXISTS phonebook;", asio::deferred);
+    co_await conn->async_query("CREATE TABLE phonebook(phone TEXT, name TEXT);", asio::deferred);
+    co_await conn->async_query(
+      "INSERT INTO phonebook VALUES ($1, $2);", psql::mp("+1 111 444 7777", "Jake"), asio::deferred);
+  }
+
+  // Reads wait until all the hosts have been probed once. With no replica available, they fail over to the primary.
+  {
+    auto conn   = co_await conn_pool.async_aquire(psql::access_mode::read_only, asio::deferred);
+    auto result = co_await conn->async_query("SELECT count(*), pg_is_in_recovery() FROM phonebook;", asio::deferred);
+    auto [count, is_replica] = as<int64_t, bool>(result);
+    std::cout << "rows:" << count << " read from " << (is_replica ? "a replica" : "the primary") << std::endl;
+  }
+
+  print_status(conn_pool);
+
+  // A host whose probe failed isn't used until a later probe reaches it, and one whose pooled connection failed is
+  // skipped for failure_backoff. A refresh probes all the hosts now instead of waiting for the next health check.
+  co_await conn_pool.async_refresh(asio::deferred);
+  print_status(conn_pool);
+}
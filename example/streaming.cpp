@@ -0,0 +1,49 @@
+#include <psql/connection.hpp>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/deferred.hpp>
+
+#include <iostream>
+
+namespace asio = boost::asio;
+
+asio::awaitable<void> async_main(std::string conninfo)
+{
+  auto exec = co_await asio::this_coro::executor;
+  auto conn = psql::connection{ exec };
+
+  co_await conn.async_connect(conninfo, asio::deferred);
+
+  // Example 1
+  // In single-row mode, each call to async_receive_rows completes with a result that contains one row.
+  co_await conn.async_query_streaming("SELECT generate_series(1, $1);", psql::mp(5), asio::deferred);
+
+  for (;;)
+  {
+    // The final result of the query contains no rows and marks the end of the stream.
+    auto rows = co_await conn.async_receive_rows(asio::deferred);
+    if (rows.empty())
+      break;
+
+    std::cout << as<int>(rows) << ' ';
+  }
+  std::cout << std::endl;
+
+  // Example 2
+  // In chunked-rows mode (libpq 17+), each result contains up to the requested number of rows, which
+  // bounds the memory usage while keeping the per-result overhead low. Older versions of libpq fall back
+  // to single-row mode.
+  co_await conn.async_query_streaming("SELECT generate_series(1, $1);", psql::mp(10000), 1000, asio::deferred);
+
+  auto sum = int64_t{};
+  for (;;)
+  {
+    auto rows = co_await conn.async_receive_rows(asio::deferred);
+    if (rows.empty())
+      break;
+
+    for (const auto row : rows)
+      sum += as<int>(row);
+  }
+  std::cout << "sum:" << sum << std::endl;
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <psql/detail/deserialization.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <span>
+
+namespace psql
+{
+// A non-owning view of a one-dimensional array in binary format, elements are decoded on access. The view refers
+// to the memory of the result it was deserialized from. NULL elements are decoded as value-initialized objects.
+template<typename T>
+class array_view
+{
+  std::span<const char> elements_;
+  size_t size_{};
+  bool has_nulls_{};
+
+public:
+  class const_iterator;
+
+  using value_type = T;
+
+  array_view() = default;
+
+  array_view(std::span<const char> elements, size_t size, bool has_nulls) noexcept
+    : elements_{ elements }
+    , size_{ size }
+    , has_nulls_{ has_nulls }
+  {
+  }
+
+  const_iterator begin() const noexcept;
+
+  const_iterator end() const noexcept;
+
+  size_t size() const noexcept
+  {
+    return size_;
+  }
+
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return size_ == 0;
+  }
+
+  T front() const
+  {
+    return *begin();
+  }
+
+  // Elements of fixed-width types are located directly unless the array contains NULLs.
+  T operator[](size_t index) const
+  {
+    if constexpr (std::is_arithmetic_v<T>)
+    {
+      if (!has_nulls_)
+        return decode(elements_.subspan(index * (4 + sizeof(T)), 4 + sizeof(T)));
+    }
+    return *std::next(begin(), index);
+  }
+
+  T at(size_t index) const
+  {
+    if (index < size_)
+      return (*this)[index];
+
+    throw std::out_of_range{ std::string{ "No element at index " } + std::to_string(index) + " exists" };
+  }
+
+  // Decodes the element at the start of the buffer.
+  static T decode(std::span<const char> buffer)
+  {
+    auto value = T{};
+    if (auto length = element_length(buffer); length != -1)
+      detail::deserialize(buffer.subspan(4, length), value);
+    return value;
+  }
+
+  static int32_t element_length(std::span<const char> buffer)
+  {
+    auto length = int32_t{};
+    detail::deserialize<int32_t>(buffer, length);
+    return length;
+  }
+};
+
+template<typename T>
+class array_view<T>::const_iterator
+{
+  std::span<const char> buffer_;
+
+public:
+  using value_type        = T;
+  using difference_type   = std::ptrdiff_t;
+  using iterator_category = std::forward_iterator_tag;
+  using pointer           = void;
+  using reference         = T;
+
+  const_iterator() = default;
+
+  explicit const_iterator(std::span<const char> buffer) noexcept
+    : buffer_{ buffer }
+  {
+  }
+
+  const_iterator operator++(int)
+  {
+    const auto tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  const_iterator& operator++()
+  {
+    buffer_ = buffer_.subspan(4 + std::max(array_view::element_length(buffer_), 0));
+    return *this;
+  }
+
+  bool operator!=(const const_iterator& rhs) const
+  {
+    return !(*this == rhs);
+  }
+
+  bool operator==(const const_iterator& rhs) const
+  {
+    return buffer_.data() == rhs.buffer_.data();
+  }
+
+  T operator*() const
+  {
+    return array_view::decode(buffer_);
+  }
+};
+
+template<typename T>
+typename array_view<T>::const_iterator array_view<T>::begin() const noexcept
+{
+  return const_iterator{ elements_ };
+}
+
+template<typename T>
+typename array_view<T>::const_iterator array_view<T>::end() const noexcept
+{
+  return const_iterator{ elements_.subspan(elements_.size()) };
+}
+
+namespace detail
+{
+template<typename T>
+struct oid_of_impl<array_view<T>> : oid_of_impl<std::vector<T>>
+{
+};
+
+template<typename T>
+struct deserialize_impl<array_view<T>>
+{
+  static void apply(std::span<const char> buffer, array_view<T>& view)
+  {
+    int32_t dimensions_count = {};
+    deserialize<int32_t>(buffer.subspan(0), dimensions_count);
+
+    // Empty arrays have no dimensions.
+    if (dimensions_count == 0)
+    {
+      view = {};
+      return;
+    }
+
+    if (dimensions_count != 1)
+      throw std::runtime_error{ "Unexpected multidimensional array" };
+
+    int32_t has_nulls = {};
+    deserialize<int32_t>(buffer.subspan(4), has_nulls);
+
+    deserialize_and_verify_oid(buffer.subspan(8), oid_of<T>());
+
+    int32_t size = {};
+    deserialize<int32_t>(buffer.subspan(12), size);
+
+    view = { buffer.subspan(20), static_cast<size_t>(size), has_nulls != 0 };
+  }
+};
+} // namespace detail
+} // namespace psql
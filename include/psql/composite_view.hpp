@@ -0,0 +1,80 @@
+#pragma once
+
+#include <psql/detail/deserialization.hpp>
+
+#include <algorithm>
+#include <span>
+#include <tuple>
+
+namespace psql
+{
+// A non-owning view of a composite value in binary format, members are decoded on access. The view refers to the
+// memory of the result it was deserialized from. NULL members are decoded as value-initialized objects.
+template<typename... Ts>
+class composite_view
+{
+  std::span<const char> members_;
+
+public:
+  composite_view() = default;
+
+  explicit composite_view(std::span<const char> members) noexcept
+    : members_{ members }
+  {
+  }
+
+  static constexpr size_t size() noexcept
+  {
+    return sizeof...(Ts);
+  }
+
+  template<size_t I>
+  std::tuple_element_t<I, std::tuple<Ts...>> get() const
+  {
+    using member_type = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    auto buffer = members_;
+    for (size_t i = 0; i < I; i++)
+      buffer = buffer.subspan(8 + std::max(member_length(buffer), 0));
+
+    detail::deserialize_and_verify_oid(buffer, detail::oid_of<member_type>());
+
+    auto value = member_type{};
+    if (auto length = member_length(buffer); length != -1)
+      detail::deserialize(buffer.subspan(8, length), value);
+    return value;
+  }
+
+private:
+  static int32_t member_length(std::span<const char> buffer)
+  {
+    auto length = int32_t{};
+    detail::deserialize<int32_t>(buffer.subspan(4), length);
+    return length;
+  }
+};
+
+template<size_t I, typename... Ts>
+auto get(const composite_view<Ts...>& view)
+{
+  return view.template get<I>();
+}
+
+namespace detail
+{
+template<typename... Ts>
+struct builtin<composite_view<Ts...>> : builtin<std::tuple<Ts...>>
+{
+};
+
+template<typename... Ts>
+struct deserialize_impl<composite_view<Ts...>>
+{
+  static void apply(std::span<const char> buffer, composite_view<Ts...>& view)
+  {
+    deserialize_impl<std::tuple<Ts...>>::verify_member_counts(buffer, sizeof...(Ts));
+    view = composite_view<Ts...>{ buffer.subspan(4) };
+  }
+};
+} // namespace detail
+} // namespace psql
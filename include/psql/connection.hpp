@@ -1,27 +1,57 @@
 #pragma once
 
+#include <psql/detail/copy.hpp>
 #include <psql/detail/extract_new_udts.hpp>
+#include <psql/detail/handler_memory.hpp>
+#include <psql/detail/statement_cache.hpp>
+#include <psql/metrics.hpp>
 #include <psql/notification.hpp>
+#include <psql/oid_cache.hpp>
 #include <psql/pipeline.hpp>
+#include <psql/prepared_statement.hpp>
 #include <psql/result.hpp>
 #include <psql/sqlstate.hpp>
+#include <psql/tracer.hpp>
 
 #include <boost/asio/any_completion_handler.hpp>
 #include <boost/asio/append.hpp>
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/bind_allocator.hpp>
 #include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/bind_executor.hpp>
 #include <boost/asio/compose.hpp>
 #include <boost/asio/coroutine.hpp>
-#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/posix/stream_descriptor.hpp>
 #include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/circular_buffer.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <numeric>
+#include <ranges>
+#include <thread>
 
 namespace psql
 {
 namespace asio = boost::asio;
 
+template<typename Executor>
+class basic_pipeline_session;
+
 template<typename Executor = asio::any_io_executor>
 class basic_connection
 {
+  template<typename>
+  friend class basic_pipeline_session;
+
   struct pgconn_deleter
   {
     void operator()(PGconn* p)
@@ -30,16 +60,57 @@ class basic_connection
     }
   };
 
+#ifdef LIBPQ_HAS_ASYNC_CANCEL
+  struct pgcancel_conn_deleter
+  {
+    void operator()(PGcancelConn* p)
+    {
+      PQcancelFinish(p);
+    }
+  };
+#endif
+
   using socket_type = asio::posix::basic_stream_descriptor<Executor>;
   using wait_type   = typename socket_type::wait_type;
   using error_code  = boost::system::error_code;
+  using timer_type =
+    asio::basic_waitable_timer<std::chrono::steady_clock, asio::wait_traits<std::chrono::steady_clock>, Executor>;
+
+  // The grace period of a cancelled receive. It is kept on the heap, so the timer doesn't refer to a connection that
+  // has been moved meanwhile.
+  struct receive_cancellation
+  {
+    explicit receive_cancellation(const Executor& exec)
+      : grace_timer{ exec }
+    {
+    }
+
+    asio::cancellation_signal signal; // abandons the read wait of the cancelled receive only
+    timer_type grace_timer;
+    size_t id{}; // identifies the cancelled receive, so a timer that fired late doesn't abandon the next one
+  };
 
   std::unique_ptr<PGconn, pgconn_deleter> pgconn_;
   socket_type socket_;
   std::unique_ptr<asio::cancellation_signal> notification_cs_ = std::make_unique<asio::cancellation_signal>();
   detail::oid_map oid_map_;
+  std::shared_ptr<oid_cache> oid_cache_;
+  std::uint64_t oid_cache_generation_{}; // of the shared cache when oid_map_ was last in sync with it
   std::vector<detail::udt_pair> new_udts_;
   std::string buffer_;
+  bool auto_pipelining_{};
+  bool is_auto_pipeline_running_{};
+  // Keeps its capacity, so queueing the handlers of auto-pipelined queries doesn't allocate once warmed up.
+  boost::circular_buffer<asio::any_completion_handler<void(error_code, result)>> auto_pipeline_handlers_;
+  detail::statement_cache statement_cache_;
+  std::unique_ptr<detail::connection_metrics_recorder> metrics_ =
+    std::make_unique<detail::connection_metrics_recorder>();
+  std::shared_ptr<detail::handler_memory> handler_memory_ = std::make_shared<detail::handler_memory>();
+  std::shared_ptr<query_tracer> tracer_;
+  detail::exchange_times exchange_times_;
+  std::chrono::steady_clock::duration cancel_grace_period_ = std::chrono::seconds{ 1 };
+  std::unique_ptr<receive_cancellation> receive_cancellation_ =
+    std::make_unique<receive_cancellation>(socket_.get_executor());
 
 public:
   using executor_type = Executor;
@@ -85,13 +156,84 @@ public:
 
   void close() noexcept
   {
+    // PQfinish closes the socket, which must not be closed again by the descriptor.
+    if (pgconn_)
+      socket_.release();
     pgconn_.reset();
   }
 
+  // Latency is measured for async_query, async_query_prepared, async_exec_pipeline and the COPY operations.
+  connection_metrics metrics() const noexcept
+  {
+    auto result                    = metrics_->snapshot();
+    result.num_handler_allocations = handler_memory_->num_allocations();
+    return result;
+  }
+
+  bool auto_pipelining() const noexcept
+  {
+    return auto_pipelining_;
+  }
+
+  // When enabled, concurrent async_query, async_query_prepared, async_prepare and async_describe_* operations are
+  // sent back-to-back in pipeline mode instead of waiting for each other. Every query is followed by its own sync
+  // point, so each one still runs in its own implicit transaction, and results are matched to the operations in
+  // FIFO order. Pipeline mode is left as soon as no query is in flight. While queries are in flight, the
+  // async_exec_pipeline*, async_query_streaming and COPY operations fail with error::pipeline_mode_in_use, and a
+  // basic_pipeline_session can't be started. Pipelined operations can't be cancelled one by one: a cancellation of
+  // one of them is ignored, as a cancel request would hit whichever query the server is running at that moment.
+  void auto_pipelining(bool value) noexcept
+  {
+    auto_pipelining_ = value;
+  }
+
+  const std::shared_ptr<oid_cache>& shared_oid_cache() const noexcept
+  {
+    return oid_cache_;
+  }
+
+  // Shares the Oids of user-defined types with the other connections using the same cache.
+  void shared_oid_cache(std::shared_ptr<oid_cache> cache) noexcept
+  {
+    oid_cache_generation_ = cache ? cache->generation() : 0;
+    oid_cache_            = std::move(cache);
+  }
+
+  size_t statement_cache_capacity() const noexcept
+  {
+    return statement_cache_.capacity();
+  }
+
+  // A non-zero capacity enables the automatic prepared statement cache of async_query. The first execution of a
+  // query text prepares and executes it in a single pipelined round trip, later ones use PQsendQueryPrepared, and
+  // the least recently used statements are deallocated on the server when the cache overflows.
+  void statement_cache_capacity(size_t value)
+  {
+    statement_cache_.capacity(value);
+  }
+
+  std::chrono::steady_clock::duration cancel_grace_period() const noexcept
+  {
+    return cancel_grace_period_;
+  }
+
+  // How long a cancelled operation waits for the server to abort its query before abandoning it. An abandoned query
+  // leaves the connection busy, it should be closed then.
+  void cancel_grace_period(std::chrono::steady_clock::duration value) noexcept
+  {
+    cancel_grace_period_ = value;
+  }
+
+  // Traces the phases of async_query and async_query_prepared operations, a null tracer turns tracing off.
+  void tracer(std::shared_ptr<query_tracer> value) noexcept
+  {
+    tracer_ = std::move(value);
+  }
+
   template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
   auto async_connect(std::string conninfo, CompletionToken&& token = CompletionToken{})
   {
-    return asio::async_compose<CompletionToken, void(error_code)>(
+    return async_compose_recycled<void(error_code)>(
       [this, conninfo = std::move(conninfo), init = true](auto& self, error_code ec = {}) mutable
       {
         if (ec)
@@ -99,6 +241,9 @@ public:
 
         if (std::exchange(init, false))
         {
+          // Reconnecting replaces the previous connection, whose socket is closed by PQfinish.
+          if (socket_.is_open())
+            socket_.release();
           pgconn_.reset(PQconnectStart(conninfo.data()));
 
           if (PQstatus(pgconn_.get()) == CONNECTION_BAD)
@@ -126,28 +271,143 @@ public:
 
         return self.complete({});
       },
-      token,
-      socket_);
+      std::forward<CompletionToken>(token));
+  }
+
+  // Asks the server to cancel the query that is running on the connection, and completes once the request has been
+  // delivered. The cancelled query fails with sqlstate::query_canceled, unless it completed before the request was
+  // processed. Operations that are waiting for a result send this request themselves when they are cancelled.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_cancel(CompletionToken&& token = CompletionToken{})
+  {
+#ifdef LIBPQ_HAS_ASYNC_CANCEL
+    return async_compose_recycled<void(error_code)>(
+      [this,
+       cancel_conn   = std::unique_ptr<PGcancelConn, pgcancel_conn_deleter>{},
+       cancel_socket = std::unique_ptr<socket_type>{}](auto& self, error_code ec = {}) mutable
+      {
+        // The socket belongs to the cancel connection, and might change between the polls.
+        if (cancel_socket && cancel_socket->is_open())
+          cancel_socket->release();
+
+        if (ec)
+          return self.complete(ec);
+
+        if (!cancel_conn)
+        {
+          cancel_conn.reset(PQcancelCreate(pgconn_.get()));
+          cancel_socket = std::make_unique<socket_type>(socket_.get_executor());
+
+          if (!cancel_conn || !PQcancelStart(cancel_conn.get()))
+            return asio::post(asio::append(std::move(self), error::pq_cancel_failed));
+        }
+
+        const auto ret = PQcancelPoll(cancel_conn.get());
+
+        if (ret == PGRES_POLLING_READING || ret == PGRES_POLLING_WRITING)
+        {
+          cancel_socket->assign(PQcancelSocket(cancel_conn.get()));
+          return cancel_socket->async_wait(
+            ret == PGRES_POLLING_READING ? wait_type::wait_read : wait_type::wait_write, std::move(self));
+        }
+
+        if (ret == PGRES_POLLING_FAILED)
+          return self.complete(error::pq_cancel_failed);
+
+        return self.complete({});
+      },
+      std::forward<CompletionToken>(token));
+#else
+    // PQcancel blocks until the request is delivered, so it's sent from a thread of its own.
+    return asio::async_initiate<CompletionToken, void(error_code)>(
+      [this](auto handler)
+      {
+        auto work = asio::make_work_guard(asio::get_associated_executor(handler, socket_.get_executor()));
+        auto* cancel = PQgetCancel(pgconn_.get());
+
+        if (!cancel)
+          return asio::post(work.get_executor(), asio::append(std::move(handler), error::pq_cancel_failed));
+
+        std::thread{ [cancel, handler = std::move(handler), work = std::move(work)]() mutable
+                     {
+                       char errbuf[256];
+                       const auto ec = PQcancel(cancel, errbuf, sizeof(errbuf))
+                                       ? error_code{}
+                                       : error_code{ error::pq_cancel_failed };
+                       PQfreeCancel(cancel);
+                       asio::post(work.get_executor(), asio::append(std::move(handler), ec));
+                     } }
+          .detach();
+      },
+      token);
+#endif
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_connect_resolved(std::string conninfo, CompletionToken&& token = CompletionToken{})
+  {
+    return async_connect_resolved(
+      std::move(conninfo), std::chrono::milliseconds{ 250 }, std::forward<CompletionToken>(token));
+  }
+
+  // Like async_connect, but the hosts of the connection string are resolved asynchronously instead of by libpq, and
+  // the attempts to connect to their addresses overlap: the next attempt starts when the previous one fails or hasn't
+  // succeeded within attempt_delay, and the first one to succeed is kept. If all of them fail, the connection is left
+  // with the last failed attempt, for its error message. Connection strings with hostaddr or Unix-domain sockets are
+  // passed to async_connect.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_connect_resolved(
+    std::string conninfo,
+    std::chrono::steady_clock::duration attempt_delay,
+    CompletionToken&& token = CompletionToken{})
+  {
+    auto&& bound_token = with_handler_memory(std::forward<CompletionToken>(token));
+    return asio::async_initiate<decltype(bound_token), void(error_code)>(
+      [this](auto handler, std::string conninfo, std::chrono::steady_clock::duration attempt_delay)
+      { async_connect_resolved_erased(std::move(conninfo), attempt_delay, std::move(handler)); },
+      bound_token,
+      std::move(conninfo),
+      attempt_delay);
+  }
+
+  // Resolves the Oids of the user-defined types, and the ones nested in them, in a single query. Types used by
+  // queries are otherwise resolved on their first use.
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_register_types(CompletionToken&& token = CompletionToken{})
+  {
+    auto&& bound_token = with_handler_memory(std::forward<CompletionToken>(token));
+    return asio::async_initiate<decltype(bound_token), void(error_code)>(
+      [this](auto handler)
+      {
+        sync_oid_map();
+        (detail::extract_new_udts<Ts>(new_udts_, oid_map_), ...);
+        async_query_oids_erased(std::move(handler));
+      },
+      bound_token);
   }
 
   template<typename Operation, typename CompletionToken = asio::default_completion_token_t<executor_type>>
   auto async_exec_pipeline(Operation&& operation, CompletionToken&& token = CompletionToken{})
   {
-    return asio::async_compose<CompletionToken, void(error_code, std::vector<result>)>(
+    return async_compose_recycled<void(error_code, std::vector<result>)>(
       [this,
        coro      = asio::coroutine{},
        results   = std::vector<result>{},
        is_thrown = false,
        index     = size_t{},
+       start     = std::chrono::steady_clock::now(),
        operation = std::forward<Operation>(operation)](auto& self, error_code ec = {}, result result = {}) mutable
       {
         if (ec)
-          return self.complete(ec, {});
+          return self.complete(finish_operation(start, ec), {});
 
         BOOST_ASIO_CORO_REENTER(coro)
         {
+          if (is_pipeline_in_use())
+            return self.complete(finish_operation(start, error::pipeline_mode_in_use), {});
+
           if (!PQenterPipelineMode(pgconn_.get()))
-            return self.complete(error::pq_enter_pipeline_mode_failed, {});
+            return self.complete(finish_operation(start, error::pq_enter_pipeline_mode_failed), {});
 
           {
             auto pipeline = psql::pipeline{ pgconn_.get(), oid_map_, buffer_ };
@@ -164,7 +424,7 @@ public:
           }
 
           if (!PQpipelineSync(pgconn_.get()))
-            return self.complete(error::pq_pipeline_sync_failed, {});
+            return self.complete(finish_operation(start, error::pq_pipeline_sync_failed), {});
 
           BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
 
@@ -174,303 +434,1564 @@ public:
             results[index] = std::move(result);
             BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
             if (result)
-              return self.complete(error::unexpected_non_null_result, {});
+              return self.complete(finish_operation(start, error::unexpected_non_null_result), {});
             index++;
           }
 
           BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
           if (PQresultStatus(result.native_handle()) != PGRES_PIPELINE_SYNC)
-            return self.complete(error::result_status_unexpected, {});
+            return self.complete(finish_operation(start, error::result_status_unexpected), {});
 
           if (!PQexitPipelineMode(pgconn_.get()))
-            return self.complete(error::pq_exit_pipeline_mode_failed, {});
+            return self.complete(finish_operation(start, error::pq_exit_pipeline_mode_failed), {});
 
           notification_cs_->emit(asio::cancellation_type::terminal);
 
           if (is_thrown)
-            return self.complete(error::exception_in_pipeline_operation, {});
+            return self.complete(finish_operation(start, error::exception_in_pipeline_operation), {});
 
           for (const auto& result : results)
           {
             if (auto ec = result_status_to_error_code(result))
-              return self.complete(ec, std::move(results));
+              return self.complete(finish_operation(start, ec), std::move(results));
           }
 
-          return self.complete({}, std::move(results));
+          return self.complete(finish_operation(start, {}), std::move(results));
         }
       },
-      token,
-      socket_);
-  }
-
-  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
-  auto async_query(std::string query, CompletionToken&& token = CompletionToken{})
-  {
-    return async_query(std::move(query), {}, std::forward<CompletionToken>(token));
+      std::forward<CompletionToken>(token));
   }
 
-  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
-  auto async_query(std::string query, params<Ts...> params, CompletionToken&& token = CompletionToken{})
+  // Like async_exec_pipeline, but hands each result to `on_result(index, result)` in order as soon as it is received,
+  // instead of collecting them, so each PGresult is freed right after being handled. Completes with the error of the
+  // first failed result, if any. Once `operation` or `on_result` has thrown, the remaining results are discarded and
+  // the operation completes with exception_in_pipeline_operation.
+  template<
+    typename Operation,
+    typename ResultHandler,
+    typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_exec_pipeline_streamed(
+    Operation&& operation,
+    ResultHandler&& on_result,
+    CompletionToken&& token = CompletionToken{})
   {
-    return asio::async_compose<CompletionToken, void(error_code, result)>(
-      [this, coro = asio::coroutine{}, query = std::move(query), params = std::move(params)](
-        auto& self, error_code ec = {}, result result = {}) mutable
+    return async_compose_recycled<void(error_code)>(
+      [this,
+       coro        = asio::coroutine{},
+       num_results = size_t{},
+       index       = size_t{},
+       is_thrown   = false,
+       first_ec    = error_code{},
+       start       = std::chrono::steady_clock::now(),
+       operation   = std::forward<Operation>(operation),
+       on_result   = std::forward<ResultHandler>(on_result)](auto& self, error_code ec = {}, result result = {}) mutable
       {
+        if (ec)
+          return self.complete(finish_operation(start, ec));
+
         BOOST_ASIO_CORO_REENTER(coro)
         {
-          (detail::extract_new_udts<Ts>(new_udts_, oid_map_), ...);
+          if (is_pipeline_in_use())
+            return self.complete(finish_operation(start, error::pipeline_mode_in_use));
+
+          if (!PQenterPipelineMode(pgconn_.get()))
+            return self.complete(finish_operation(start, error::pq_enter_pipeline_mode_failed));
 
-          if (!new_udts_.empty())
           {
-            BOOST_ASIO_CORO_YIELD async_query_oids(std::move(self));
-            if (ec)
-              return self.complete(ec, {});
+            auto pipeline = psql::pipeline{ pgconn_.get(), oid_map_, buffer_ };
+            try
+            {
+              operation(pipeline);
+            }
+            catch (...)
+            {
+              is_thrown = true;
+              pipeline.push_query("ROLLBACK;");
+            }
+            num_results = pipeline.size();
           }
 
+          if (!PQpipelineSync(pgconn_.get()))
+            return self.complete(finish_operation(start, error::pq_pipeline_sync_failed));
+
+          BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+
+          while (index < num_results)
           {
-            auto [t, v, l, f] = detail::serialize(oid_map_, buffer_, params);
+            BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
 
-            if (!PQsendQueryParams(pgconn_.get(), query.data(), t.size(), t.data(), v.data(), l.data(), f.data(), 1))
-              return self.complete(error::pq_send_query_params_failed, {});
+            if (!first_ec)
+              first_ec = result_status_to_error_code(result);
+
+            if (!is_thrown)
+            {
+              try
+              {
+                on_result(index, std::move(result));
+              }
+              catch (...)
+              {
+                is_thrown = true;
+              }
+            }
+
+            BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+            if (result)
+              return self.complete(finish_operation(start, error::unexpected_non_null_result));
+            index++;
           }
-          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
-          return self.complete(ec, std::move(result));
+
+          BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+          if (PQresultStatus(result.native_handle()) != PGRES_PIPELINE_SYNC)
+            return self.complete(finish_operation(start, error::result_status_unexpected));
+
+          if (!PQexitPipelineMode(pgconn_.get()))
+            return self.complete(finish_operation(start, error::pq_exit_pipeline_mode_failed));
+
+          notification_cs_->emit(asio::cancellation_type::terminal);
+
+          if (is_thrown)
+            return self.complete(finish_operation(start, error::exception_in_pipeline_operation));
+
+          return self.complete(finish_operation(start, first_ec));
         }
       },
-      token,
-      socket_);
+      std::forward<CompletionToken>(token));
   }
 
-  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
-  auto async_prepare(std::string stmt_name, std::string query, CompletionToken&& token = CompletionToken{})
+  // Like async_exec_pipeline_streamed, but the queries are produced incrementally: `producer(pipeline)` is called
+  // repeatedly to push the next queries until it returns false, and only while the queries in flight fit in `window`.
+  // Pushed queries are flushed and their results are handed to `on_result(index, result)` while more are produced, so
+  // the memory in use doesn't grow with the size of the batch. A producer that has no query ready can return true
+  // without pushing any, it's called again once a result has been received. If nothing is in flight then, there is
+  // nothing to wait for and the pipeline ends as if it had returned false. Producers that wait for their input should
+  // use a pipeline_session instead. The producer isn't called anymore once a query has failed, as the rest of the
+  // pipeline is aborted anyway.
+  template<
+    typename Producer,
+    typename ResultHandler,
+    typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_exec_pipeline_windowed(
+    Producer&& producer,
+    ResultHandler&& on_result,
+    pipeline_window window,
+    CompletionToken&& token = CompletionToken{})
   {
-    return asio::async_compose<CompletionToken, void(error_code, result)>(
-      [this, coro = asio::coroutine{}, query = std::move(query), stmt_name = std::move(stmt_name)](
+    return async_compose_recycled<void(error_code)>(
+      [this,
+       coro            = asio::coroutine{},
+       window          = window,
+       batches         = std::deque<std::pair<size_t, size_t>>{}, // ends of the produced batches, in queries and bytes
+       num_pushed      = size_t{},
+       bytes_pushed    = size_t{},
+       bytes_completed = size_t{},
+       index           = size_t{},
+       is_exhausted    = false,
+       is_synced       = false,
+       is_thrown       = false,
+       first_ec        = error_code{},
+       start           = std::chrono::steady_clock::now(),
+       producer        = std::forward<Producer>(producer),
+       on_result       = std::forward<ResultHandler>(on_result)](
         auto& self, error_code ec = {}, result result = {}) mutable
       {
+        if (ec)
+          return self.complete(finish_operation(start, ec));
+
         BOOST_ASIO_CORO_REENTER(coro)
         {
-          if (!PQsendPrepare(pgconn_.get(), stmt_name.data(), query.data(), 0, nullptr))
-            return self.complete(error::pq_send_prepare_failed, {});
+          if (is_pipeline_in_use())
+            return self.complete(finish_operation(start, error::pipeline_mode_in_use));
 
-          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
-          return self.complete(ec, std::move(result));
+          if (!PQenterPipelineMode(pgconn_.get()))
+            return self.complete(finish_operation(start, error::pq_enter_pipeline_mode_failed));
+
+          for (;;)
+          {
+            {
+              auto pipeline = psql::pipeline{ pgconn_.get(), oid_map_, buffer_ };
+              is_exhausted  = is_exhausted || is_thrown || first_ec;
+
+              // A batch is always produced when nothing is in flight, even if it exceeds the window on its own.
+              while (!is_exhausted &&
+                     (num_pushed + pipeline.size() == index ||
+                      (num_pushed + pipeline.size() - index < window.max_queries &&
+                       bytes_pushed + pipeline.num_bytes() - bytes_completed < window.max_bytes)))
+              {
+                const auto size = pipeline.size();
+                try
+                {
+                  is_exhausted = !producer(pipeline);
+                }
+                catch (...)
+                {
+                  is_exhausted = is_thrown = true;
+                }
+
+                if (pipeline.size() == size)
+                {
+                  // Nothing in flight would call the producer again, the pipeline would never end.
+                  if (num_pushed + size == index)
+                    is_exhausted = true;
+                  break;
+                }
+
+                batches.emplace_back(num_pushed + pipeline.size(), bytes_pushed + pipeline.num_bytes());
+              }
+
+              if (is_exhausted && !is_synced)
+              {
+                if (is_thrown)
+                  pipeline.push_query("ROLLBACK;");
+
+                if (!PQpipelineSync(pgconn_.get()))
+                  return self.complete(finish_operation(start, error::pq_pipeline_sync_failed));
+                is_synced = true;
+              }
+              else if (pipeline.size() != 0 && !PQsendFlushRequest(pgconn_.get()))
+              {
+                // Without a sync point the server only sends the results it has when asked to.
+                return self.complete(finish_operation(start, error::pq_send_flush_request_failed));
+              }
+
+              num_pushed += pipeline.size();
+              bytes_pushed += pipeline.num_bytes();
+            }
+
+            BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+
+            // Once the producer is exhausted, the sync point has been pushed by now.
+            if (index == num_pushed)
+              break;
+
+            BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+
+            if (!first_ec)
+              first_ec = result_status_to_error_code(result);
+
+            if (!is_thrown)
+            {
+              try
+              {
+                on_result(index, std::move(result));
+              }
+              catch (...)
+              {
+                is_thrown = true;
+              }
+            }
+
+            BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+            if (result)
+              return self.complete(finish_operation(start, error::unexpected_non_null_result));
+            index++;
+
+            // The bytes of a batch are released once all of its queries have completed.
+            while (!batches.empty() && batches.front().first <= index)
+            {
+              bytes_completed = batches.front().second;
+              batches.pop_front();
+            }
+          }
+
+          BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+          if (PQresultStatus(result.native_handle()) != PGRES_PIPELINE_SYNC)
+            return self.complete(finish_operation(start, error::result_status_unexpected));
+
+          if (!PQexitPipelineMode(pgconn_.get()))
+            return self.complete(finish_operation(start, error::pq_exit_pipeline_mode_failed));
+
+          notification_cs_->emit(asio::cancellation_type::terminal);
+
+          if (is_thrown)
+            return self.complete(finish_operation(start, error::exception_in_pipeline_operation));
+
+          return self.complete(finish_operation(start, first_ec));
         }
       },
-      token,
-      socket_);
+      std::forward<CompletionToken>(token));
   }
 
   template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
-  auto async_query_prepared(std::string stmt_name, CompletionToken&& token = CompletionToken{})
+  auto async_query(std::string query, CompletionToken&& token = CompletionToken{})
   {
-    return async_query_prepared(std::move(stmt_name), {}, std::forward<CompletionToken>(token));
+    return async_query(std::move(query), {}, std::forward<CompletionToken>(token));
   }
 
   template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
-  auto async_query_prepared(std::string stmt_name, params<Ts...> params, CompletionToken&& token = CompletionToken{})
+  auto async_query(std::string query, params<Ts...> params, CompletionToken&& token = CompletionToken{})
   {
-    return asio::async_compose<CompletionToken, void(error_code, result)>(
-      [this, coro = asio::coroutine{}, stmt_name = std::move(stmt_name), params = std::move(params)](
-        auto& self, error_code ec = {}, result result = {}) mutable
+    return async_compose_recycled<void(error_code, result)>(
+      [this,
+       coro         = asio::coroutine{},
+       query        = std::move(query),
+       params       = std::move(params),
+       is_cache_hit = false,
+       param_oids   = std::array<uint32_t, sizeof...(Ts)>{}, // to find the cache entry again if it fails
+       num_segments = size_t{},
+       trace        = query_trace{},
+       start        = std::chrono::steady_clock::now()](auto& self, error_code ec = {}, result result = {}) mutable
       {
         BOOST_ASIO_CORO_REENTER(coro)
         {
-          (detail::extract_new_udts<Ts>(new_udts_, oid_map_), ...);
+          sync_oid_map();
+          detail::extract_new_udts_of_params<Ts...>(new_udts_, oid_map_);
 
           if (!new_udts_.empty())
           {
             BOOST_ASIO_CORO_YIELD async_query_oids(std::move(self));
             if (ec)
-              return self.complete(ec, {});
+              return self.complete(finish_failed_query(trace, query, start, ec), {});
           }
 
+          trace_point(trace.udts_resolved);
+
+          if (!enter_auto_pipeline_mode())
+            return self.complete(finish_failed_query(trace, query, start, error::pq_enter_pipeline_mode_failed), {});
+
           {
             auto [t, v, l, f] = detail::serialize(oid_map_, buffer_, params);
+            trace.bytes_sent  = query.size() + std::reduce(l.begin(), l.end(), size_t{});
+            detail::increment(metrics_->bytes_sent, trace.bytes_sent);
 
-            if (!PQsendQueryPrepared(pgconn_.get(), stmt_name.data(), t.size(), v.data(), l.data(), f.data(), 1))
-              return self.complete(error::pq_send_query_prepared_failed, {});
+            if (statement_cache_.capacity() == 0)
+            {
+              if (!PQsendQueryParams(
+                    pgconn_.get(), query.data(), t.size(), t.data(), v.data(), l.data(), f.data(), 1))
+                return self.complete(finish_failed_query(trace, query, start, error::pq_send_query_params_failed), {});
+            }
+            else if (const auto* stmt_name = statement_cache_.find(statement_cache_.make_key(query, param_oids = t)))
+            {
+              is_cache_hit = true;
+              if (!PQsendQueryPrepared(pgconn_.get(), stmt_name->data(), t.size(), v.data(), l.data(), f.data(), 1))
+                return self.complete(
+                  finish_failed_query(trace, query, start, error::pq_send_query_prepared_failed), {});
+            }
+            else
+            {
+              if (!PQenterPipelineMode(pgconn_.get()))
+                return self.complete(
+                  finish_failed_query(trace, query, start, error::pq_enter_pipeline_mode_failed), {});
+
+              const auto& stmt_name = statement_cache_.insert(statement_cache_.make_key(query, param_oids));
+
+              if (!send_statement_deallocations(num_segments))
+                return self.complete(finish_failed_query(trace, query, start, error::pq_send_query_params_failed), {});
+
+              if (!PQsendPrepare(pgconn_.get(), stmt_name.data(), query.data(), t.size(), t.data()))
+                return self.complete(finish_failed_query(trace, query, start, error::pq_send_prepare_failed), {});
+
+              if (!PQsendQueryPrepared(pgconn_.get(), stmt_name.data(), t.size(), v.data(), l.data(), f.data(), 1))
+                return self.complete(
+                  finish_failed_query(trace, query, start, error::pq_send_query_prepared_failed), {});
+
+              num_segments++;
+            }
           }
 
-          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
-          return self.complete(ec, std::move(result));
+          trace_point(trace.serialized);
+
+          if (num_segments != 0)
+          {
+            BOOST_ASIO_CORO_YIELD async_generic_pipelined_query(num_segments, std::move(self));
+
+            // Whether the statement got prepared is unknown, a deallocation of it is harmless either way.
+            if (ec)
+              statement_cache_.evict(statement_cache_.make_key(query, param_oids));
+          }
+          else
+          {
+            BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
+
+            // The statement is gone from the server, e.g. after a DISCARD ALL, and gets prepared again next time.
+            if (is_cache_hit && ec == sqlstate::invalid_sql_statement_name)
+              statement_cache_.erase(statement_cache_.make_key(query, param_oids));
+          }
+
+          finish_trace(trace, query, start, ec, result);
+          return self.complete(finish_operation(start, ec), std::move(result));
         }
       },
-      token,
-      socket_);
+      std::forward<CompletionToken>(token));
   }
 
   template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
-  auto async_describe_prepared(std::string stmt_name, CompletionToken&& token = CompletionToken{})
+  auto async_query_streaming(std::string query, CompletionToken&& token = CompletionToken{})
   {
-    return asio::async_compose<CompletionToken, void(error_code, result)>(
-      [this, coro = asio::coroutine{}, stmt_name = std::move(stmt_name)](
-        auto& self, error_code ec = {}, result result = {}) mutable
-      {
-        BOOST_ASIO_CORO_REENTER(coro)
-        {
-          if (!PQsendDescribePrepared(pgconn_.get(), stmt_name.data()))
-            return self.complete(error::pq_send_describe_prepared_failed, {});
+    return async_query_streaming(std::move(query), {}, 1, std::forward<CompletionToken>(token));
+  }
 
-          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_query_streaming(std::string query, params<Ts...> params, CompletionToken&& token = CompletionToken{})
+  {
+    return async_query_streaming(std::move(query), std::move(params), 1, std::forward<CompletionToken>(token));
+  }
+
+  // Sends the query in single-row mode, or in chunked-rows mode when chunk_size > 1 and libpq supports it.
+  // The rows must then be read with async_receive_rows until it completes with an empty result.
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_query_streaming(
+    std::string query,
+    params<Ts...> params,
+    int chunk_size,
+    CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code)>(
+      [this,
+       coro    = asio::coroutine{},
+       query   = std::move(query),
+       params  = std::move(params),
+       chunk_size,
+       mode_ec = error_code{}](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        if (ec)
+          return self.complete(ec);
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          // The row modes can't be set on a query in a pipeline.
+          if (is_pipeline_in_use())
+            return self.complete(error::pipeline_mode_in_use);
+
+          sync_oid_map();
+          detail::extract_new_udts_of_params<Ts...>(new_udts_, oid_map_);
+
+          if (!new_udts_.empty())
+          {
+            BOOST_ASIO_CORO_YIELD async_query_oids(std::move(self));
+          }
+
+          {
+            auto [t, v, l, f] = detail::serialize(oid_map_, buffer_, params);
+
+            if (!PQsendQueryParams(pgconn_.get(), query.data(), t.size(), t.data(), v.data(), l.data(), f.data(), 1))
+              return self.complete(error::pq_send_query_params_failed);
+          }
+
+#ifdef LIBPQ_HAS_CHUNK_MODE
+          if (chunk_size > 1)
+          {
+            if (!PQsetChunkedRowsMode(pgconn_.get(), chunk_size))
+              mode_ec = error::pq_set_chunked_rows_mode_failed;
+          }
+          else
+#endif
+          {
+            if (!PQsetSingleRowMode(pgconn_.get()))
+              mode_ec = error::pq_set_single_row_mode_failed;
+          }
+
+          BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+
+          if (!mode_ec)
+            return self.complete({});
+
+          // The query has been sent already, its results are discarded so the connection stays usable.
+          for (;;)
+          {
+            BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+            if (!result)
+              break;
+          }
+
+          return self.complete(mode_ec);
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  // Completes with the next row (or chunk of rows) of a query started with async_query_streaming.
+  // The final result of the query has no rows, which marks the end of the stream.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_receive_rows(CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, result)>(
+      [this, coro = asio::coroutine{}, stored_result = result{}](
+        auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        if (ec)
+          return self.complete(ec, {});
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+
+          if (is_partial_tuples_result(result))
+            return self.complete({}, std::move(result));
+
+          stored_result = std::move(result);
+
+          BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+          if (result)
+            return self.complete(error::unexpected_non_null_result, {});
+
+          notification_cs_->emit(asio::cancellation_type::terminal);
+          auto result_ec = result_status_to_error_code(stored_result);
+          return self.complete(result_ec, std::move(stored_result));
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_prepare(std::string stmt_name, std::string query, CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, result)>(
+      [this, coro = asio::coroutine{}, query = std::move(query), stmt_name = std::move(stmt_name)](
+        auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if (!enter_auto_pipeline_mode())
+            return self.complete(error::pq_enter_pipeline_mode_failed, {});
+
+          if (!PQsendPrepare(pgconn_.get(), stmt_name.data(), query.data(), 0, nullptr))
+            return self.complete(error::pq_send_prepare_failed, {});
+
+          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
           return self.complete(ec, std::move(result));
         }
       },
-      token,
-      socket_);
+      std::forward<CompletionToken>(token));
+  }
+
+  // Prepares a statement with parameters of the types Ts, which are sent to the server instead of being inferred,
+  // and describes its result in the same round trip.
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_prepare_statement(std::string stmt_name, std::string query, CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, prepared_statement<Ts...>)>(
+      [this,
+       coro       = asio::coroutine{},
+       query      = std::move(query),
+       stmt_name  = std::move(stmt_name),
+       param_oids = std::array<uint32_t, sizeof...(Ts)>{}](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          sync_oid_map();
+          detail::extract_new_udts_of_params<Ts...>(new_udts_, oid_map_);
+
+          if (!new_udts_.empty())
+          {
+            BOOST_ASIO_CORO_YIELD async_query_oids(std::move(self));
+            if (ec)
+              return self.complete(ec, {});
+          }
+
+          if (!enter_auto_pipeline_mode() || !PQenterPipelineMode(pgconn_.get()))
+            return self.complete(error::pq_enter_pipeline_mode_failed, {});
+
+          param_oids = { detail::oid_of<Ts>(oid_map_)... };
+
+          if (!PQsendPrepare(pgconn_.get(), stmt_name.data(), query.data(), param_oids.size(), param_oids.data()))
+            return self.complete(error::pq_send_prepare_failed, {});
+
+          if (!PQsendDescribePrepared(pgconn_.get(), stmt_name.data()))
+            return self.complete(error::pq_send_describe_prepared_failed, {});
+
+          BOOST_ASIO_CORO_YIELD async_generic_pipelined_query(1, std::move(self));
+          if (ec)
+            return self.complete(ec, {});
+
+          return self.complete({}, prepared_statement<Ts...>{ std::move(stmt_name), param_oids, std::move(result) });
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_query_prepared(std::string stmt_name, CompletionToken&& token = CompletionToken{})
+  {
+    return async_query_prepared(std::move(stmt_name), {}, std::forward<CompletionToken>(token));
+  }
+
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_query_prepared(std::string stmt_name, params<Ts...> params, CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, result)>(
+      [this,
+       coro      = asio::coroutine{},
+       stmt_name = std::move(stmt_name),
+       params    = std::move(params),
+       trace     = query_trace{},
+       start     = std::chrono::steady_clock::now()](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          sync_oid_map();
+          detail::extract_new_udts_of_params<Ts...>(new_udts_, oid_map_);
+
+          if (!new_udts_.empty())
+          {
+            BOOST_ASIO_CORO_YIELD async_query_oids(std::move(self));
+            if (ec)
+              return self.complete(finish_failed_query(trace, stmt_name, start, ec), {});
+          }
+
+          trace_point(trace.udts_resolved);
+
+          if (!enter_auto_pipeline_mode())
+            return self.complete(
+              finish_failed_query(trace, stmt_name, start, error::pq_enter_pipeline_mode_failed), {});
+
+          {
+            auto [t, v, l, f] = detail::serialize(oid_map_, buffer_, params);
+            trace.bytes_sent  = std::reduce(l.begin(), l.end(), size_t{});
+            detail::increment(metrics_->bytes_sent, trace.bytes_sent);
+
+            if (!PQsendQueryPrepared(pgconn_.get(), stmt_name.data(), t.size(), v.data(), l.data(), f.data(), 1))
+              return self.complete(
+                finish_failed_query(trace, stmt_name, start, error::pq_send_query_prepared_failed), {});
+          }
+
+          trace_point(trace.serialized);
+
+          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
+          finish_trace(trace, stmt_name, start, ec, result);
+          return self.complete(finish_operation(start, ec), std::move(result));
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  // Executes a typed prepared statement. The operation shares the state of the statement instead of copying its name,
+  // and the types of the parameters were fixed when it was prepared, so only their values are serialized. The Oids of
+  // user-defined types written into the values, such as the fields of a composite, are still resolved if unknown.
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_query_prepared(
+    prepared_statement<Ts...> stmt,
+    std::type_identity_t<params<Ts...>> params,
+    CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, result)>(
+      [this,
+       coro   = asio::coroutine{},
+       stmt   = std::move(stmt),
+       params = std::move(params),
+       trace  = query_trace{},
+       start  = std::chrono::steady_clock::now()](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          sync_oid_map();
+          detail::extract_nested_udts_of_params<Ts...>(new_udts_, oid_map_);
+
+          if (!new_udts_.empty())
+          {
+            BOOST_ASIO_CORO_YIELD async_query_oids(std::move(self));
+            if (ec)
+              return self.complete(finish_failed_query(trace, stmt.name(), start, ec), {});
+          }
+
+          trace_point(trace.udts_resolved);
+
+          if (!enter_auto_pipeline_mode())
+            return self.complete(
+              finish_failed_query(trace, stmt.name(), start, error::pq_enter_pipeline_mode_failed), {});
+
+          {
+            auto [v, l, f]   = detail::serialize_values(oid_map_, buffer_, params);
+            trace.bytes_sent = std::reduce(l.begin(), l.end(), size_t{});
+            detail::increment(metrics_->bytes_sent, trace.bytes_sent);
+
+            const auto n = static_cast<int>(stmt.param_oids().size());
+            if (!PQsendQueryPrepared(pgconn_.get(), stmt.name().data(), n, v.data(), l.data(), f.data(), 1))
+              return self.complete(
+                finish_failed_query(trace, stmt.name(), start, error::pq_send_query_prepared_failed), {});
+          }
+
+          trace_point(trace.serialized);
+
+          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
+          finish_trace(trace, stmt.name(), start, ec, result);
+          return self.complete(finish_operation(start, ec), std::move(result));
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_describe_prepared(std::string stmt_name, CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, result)>(
+      [this, coro = asio::coroutine{}, stmt_name = std::move(stmt_name)](
+        auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if (!enter_auto_pipeline_mode())
+            return self.complete(error::pq_enter_pipeline_mode_failed, {});
+
+          if (!PQsendDescribePrepared(pgconn_.get(), stmt_name.data()))
+            return self.complete(error::pq_send_describe_prepared_failed, {});
+
+          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
+          return self.complete(ec, std::move(result));
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_describe_portal(std::string portal_name, CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, result)>(
+      [this, coro = asio::coroutine{}, portal_name = std::move(portal_name)](
+        auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if (!enter_auto_pipeline_mode())
+            return self.complete(error::pq_enter_pipeline_mode_failed, {});
+
+          if (!PQsendDescribePortal(pgconn_.get(), portal_name.data()))
+            return self.complete(error::pq_send_describe_portal_failed, {});
+
+          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
+          return self.complete(ec, std::move(result));
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  // Executes a `COPY ... FROM STDIN (FORMAT BINARY)` query and sends the rows in the binary COPY format.
+  // Each row is either a std::tuple or an aggregate whose fields correspond to the copied columns, rows are
+  // serialized and handed to libpq in large chunks, and the range must stay valid until the operation completes.
+  template<typename Rows, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_copy_in(std::string query, const Rows& rows, CompletionToken&& token = CompletionToken{})
+  {
+    using row_type = std::ranges::range_value_t<Rows>;
+
+    return async_compose_recycled<void(error_code, result)>(
+      [this,
+       coro          = asio::coroutine{},
+       query         = std::move(query),
+       rows          = &rows,
+       it            = std::ranges::begin(rows),
+       stored_result = result{},
+       is_last_chunk = false,
+       is_aborted    = false,
+       start         = std::chrono::steady_clock::now()](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          // COPY is not allowed in pipeline mode.
+          if (is_pipeline_in_use())
+            return self.complete(finish_operation(start, error::pipeline_mode_in_use), {});
+
+          sync_oid_map();
+          detail::extract_new_udts_of_copy_row<row_type>(new_udts_, oid_map_);
+
+          if (!new_udts_.empty())
+          {
+            BOOST_ASIO_CORO_YIELD async_query_oids(std::move(self));
+            if (ec)
+              return self.complete(finish_operation(start, ec), {});
+          }
+
+          if (!PQsendQueryParams(pgconn_.get(), query.data(), 0, nullptr, nullptr, nullptr, nullptr, 1))
+            return self.complete(finish_operation(start, error::pq_send_query_params_failed), {});
+
+          BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+          if (ec)
+            return self.complete(finish_operation(start, ec), {});
+
+          BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+          if (ec)
+            return self.complete(finish_operation(start, ec), {});
+
+          if (PQresultStatus(result.native_handle()) != PGRES_COPY_IN)
+          {
+            stored_result = std::move(result);
+
+            BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+            if (ec)
+              return self.complete(finish_operation(start, ec), {});
+            if (result)
+              return self.complete(finish_operation(start, error::unexpected_non_null_result), {});
+
+            notification_cs_->emit(asio::cancellation_type::terminal);
+            ec = result_status_to_error_code(stored_result);
+            return self.complete(
+              finish_operation(start, ec ? ec : error::result_status_unexpected), std::move(stored_result));
+          }
+
+          buffer_.clear();
+          detail::serialize_copy_header(oid_map_, buffer_);
+
+          for (;;)
+          {
+            while (it != std::ranges::end(*rows) && buffer_.size() < detail::copy_chunk_size)
+              detail::serialize_copy_row(oid_map_, buffer_, *it++);
+
+            if (it == std::ranges::end(*rows))
+            {
+              detail::serialize_copy_trailer(oid_map_, buffer_);
+              is_last_chunk = true;
+            }
+
+            for (;;)
+            {
+              {
+                const int ret = PQputCopyData(pgconn_.get(), buffer_.data(), buffer_.size());
+                if (ret == 1)
+                {
+                  detail::increment(metrics_->bytes_sent, buffer_.size());
+                  break;
+                }
+                // libpq failed to queue the data, PQerrorMessage tells why. A result might still be pending if
+                // the COPY was ended by an error from the server, it's read unless the connection is broken.
+                if (ret == -1)
+                {
+                  if (PQstatus(pgconn_.get()) == CONNECTION_BAD)
+                    return self.complete(finish_operation(start, error::pq_put_copy_data_failed), {});
+                  is_aborted = true;
+                  break;
+                }
+              }
+
+              // libpq's buffer is full, the input is consumed while it's flushed in case the server is sending
+              // an error instead of reading.
+              BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+              if (ec)
+                return self.complete(finish_operation(start, ec), {});
+            }
+
+            buffer_.clear();
+
+            if (is_last_chunk || is_aborted)
+              break;
+
+            // Applies back-pressure, the next chunk is serialized only after libpq's buffer has been flushed.
+            BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+            if (ec)
+              return self.complete(finish_operation(start, ec), {});
+          }
+
+          while (!is_aborted)
+          {
+            {
+              const int ret = PQputCopyEnd(pgconn_.get(), nullptr);
+              if (ret == 1)
+                break;
+              if (ret == -1)
+                return self.complete(finish_operation(start, error::pq_put_copy_end_failed), {});
+            }
+
+            BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+            if (ec)
+              return self.complete(finish_operation(start, ec), {});
+          }
+
+          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
+          if (is_aborted)
+            ec = error::pq_put_copy_data_failed;
+          return self.complete(finish_operation(start, ec), std::move(result));
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  // Executes a `COPY ... TO STDOUT (FORMAT BINARY)` query and invokes the handler with each tuple deserialized
+  // into Row, which is either a std::tuple or an aggregate. Rows are decoded directly from libpq's buffer, so
+  // std::string_view fields stay valid only until the handler returns.
+  template<typename Row, typename RowHandler, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_copy_out(std::string query, RowHandler&& handler, CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, result)>(
+      [this,
+       coro           = asio::coroutine{},
+       query          = std::move(query),
+       handler        = std::forward<RowHandler>(handler),
+       stored_result  = result{},
+       is_header_read = false,
+       is_malformed   = false,
+       is_thrown      = false,
+       start          = std::chrono::steady_clock::now()](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          // COPY is not allowed in pipeline mode.
+          if (is_pipeline_in_use())
+            return self.complete(finish_operation(start, error::pipeline_mode_in_use), {});
+
+          if (!PQsendQueryParams(pgconn_.get(), query.data(), 0, nullptr, nullptr, nullptr, nullptr, 1))
+            return self.complete(finish_operation(start, error::pq_send_query_params_failed), {});
+
+          BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+          if (ec)
+            return self.complete(finish_operation(start, ec), {});
+
+          BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+          if (ec)
+            return self.complete(finish_operation(start, ec), {});
+
+          if (PQresultStatus(result.native_handle()) != PGRES_COPY_OUT)
+          {
+            stored_result = std::move(result);
+
+            BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+            if (ec)
+              return self.complete(finish_operation(start, ec), {});
+            if (result)
+              return self.complete(finish_operation(start, error::unexpected_non_null_result), {});
+
+            notification_cs_->emit(asio::cancellation_type::terminal);
+            ec = result_status_to_error_code(stored_result);
+            return self.complete(
+              finish_operation(start, ec ? ec : error::result_status_unexpected), std::move(stored_result));
+          }
+
+          for (;;)
+          {
+            {
+              char* data    = nullptr;
+              const int ret = PQgetCopyData(pgconn_.get(), &data, 1);
+
+              if (ret == -1)
+                break;
+
+              if (ret == -2)
+                return self.complete(finish_operation(start, error::pq_get_copy_data_failed), {});
+
+              if (ret > 0)
+              {
+                auto guard  = std::unique_ptr<char, decltype(&PQfreemem)>{ data, &PQfreemem };
+                auto buffer = std::span<const char>{ data, static_cast<size_t>(ret) };
+                detail::increment(metrics_->bytes_received, ret);
+
+                // The header is sent along with the first tuple. After a malformed tuple the rest of the
+                // data is drained, so the connection remains usable.
+                if (!std::exchange(is_header_read, true) && !detail::deserialize_copy_header(buffer))
+                  is_malformed = true;
+
+                if (is_malformed || is_thrown || detail::is_copy_trailer(buffer))
+                  continue;
+
+                auto row = Row{};
+                try
+                {
+                  if (!detail::deserialize_copy_row(buffer, row))
+                  {
+                    is_malformed = true;
+                    continue;
+                  }
+                }
+                catch (...)
+                {
+                  is_malformed = true;
+                  continue;
+                }
+
+                // The rest of the data is drained after an exception too, the handler isn't invoked again.
+                try
+                {
+                  std::invoke(handler, std::move(row));
+                }
+                catch (...)
+                {
+                  is_thrown = true;
+                }
+                continue;
+              }
+            }
+
+            BOOST_ASIO_CORO_YIELD socket_.async_wait(wait_type::wait_read, std::move(self));
+            if (ec)
+              return self.complete(finish_operation(start, ec), {});
+
+            if (!PQconsumeInput(pgconn_.get()))
+              return self.complete(finish_operation(start, error::pq_consume_input_failed), {});
+          }
+
+          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
+          if (!ec && is_thrown)
+            ec = error::exception_in_row_handler;
+          if (!ec && is_malformed)
+            ec = error::unexpected_copy_data_format;
+          return self.complete(finish_operation(start, ec), std::move(result));
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_receive_notifcation(CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, notification)>(
+      [this, coro = asio::coroutine{}, stored_notification = notification{}, needs_rescheduling = true](
+        auto& self, error_code ec = {}) mutable
+      {
+        if (ec && !(ec == asio::error::operation_aborted && !self.cancelled()))
+          return self.complete(ec, {});
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          self.reset_cancellation_state(asio::enable_total_cancellation());
+
+          for (;;)
+          {
+            if ((stored_notification = notification{ PQnotifies(pgconn_.get()) }))
+            {
+              if (needs_rescheduling)
+              {
+                BOOST_ASIO_CORO_YIELD asio::post(std::move(self));
+              }
+
+              return self.complete({}, std::move(stored_notification));
+            }
+
+            if (asio::get_associated_cancellation_slot(self).is_connected())
+              asio::get_associated_cancellation_slot(self).assign([this](auto c) { notification_cs_->emit(c); });
+
+            BOOST_ASIO_CORO_YIELD socket_.async_wait(
+              wait_type::wait_read, asio::bind_cancellation_slot(notification_cs_->slot(), std::move(self)));
+
+            if (!PQconsumeInput(pgconn_.get()))
+              return self.complete(error::pq_consume_input_failed, {});
+          }
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  // Completes with all the notifications that have been received, waiting for the first one if there are none, so a
+  // burst of notifications is delivered in a single completion.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_receive_notifications(CompletionToken&& token = CompletionToken{})
+  {
+    return async_compose_recycled<void(error_code, std::vector<notification>)>(
+      [this, coro = asio::coroutine{}, notifications = std::vector<notification>{}, needs_rescheduling = true](
+        auto& self, error_code ec = {}) mutable
+      {
+        if (ec && !(ec == asio::error::operation_aborted && !self.cancelled()))
+          return self.complete(ec, {});
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          self.reset_cancellation_state(asio::enable_total_cancellation());
+
+          for (;;)
+          {
+            while (auto notif = notification{ PQnotifies(pgconn_.get()) })
+              notifications.push_back(std::move(notif));
+
+            if (!notifications.empty())
+            {
+              if (needs_rescheduling)
+              {
+                BOOST_ASIO_CORO_YIELD asio::post(std::move(self));
+              }
+
+              return self.complete({}, std::move(notifications));
+            }
+
+            if (asio::get_associated_cancellation_slot(self).is_connected())
+              asio::get_associated_cancellation_slot(self).assign([this](auto c) { notification_cs_->emit(c); });
+
+            BOOST_ASIO_CORO_YIELD socket_.async_wait(
+              wait_type::wait_read, asio::bind_cancellation_slot(notification_cs_->slot(), std::move(self)));
+
+            needs_rescheduling = false;
+
+            if (!PQconsumeInput(pgconn_.get()))
+              return self.complete(error::pq_consume_input_failed, {});
+          }
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  ~basic_connection()
+  {
+    // PQfinish handles the closing of the socket.
+    if (pgconn_)
+      socket_.release();
+  }
+
+private:
+  struct conninfo_options_deleter
+  {
+    void operator()(PQconninfoOption* p)
+    {
+      PQconninfoFree(p);
+    }
+  };
+
+  // The shared state of the attempts of async_connect_resolved, which all run on the executor of the connection.
+  struct connect_race
+  {
+    using resolver_type = asio::ip::basic_resolver<asio::ip::tcp, Executor>;
+    using timer_type =
+      asio::basic_waitable_timer<std::chrono::steady_clock, asio::wait_traits<std::chrono::steady_clock>, Executor>;
+
+    connect_race(
+      const Executor& exec,
+      std::chrono::steady_clock::duration attempt_delay,
+      asio::any_completion_handler<void(error_code)> handler)
+      : handler{ std::move(handler) }
+      , resolver{ exec }
+      , timer{ exec }
+      , attempt_delay{ attempt_delay }
+    {
+    }
+
+    asio::any_completion_handler<void(error_code)> handler;
+    resolver_type resolver;
+    timer_type timer;
+    std::chrono::steady_clock::duration attempt_delay;
+    std::string common_conninfo; // all the options except the host, hostaddr and port
+    std::vector<std::string> hosts;
+    std::vector<std::string> ports;
+    std::vector<std::vector<asio::ip::tcp::endpoint>> endpoints; // of each host
+    std::vector<std::string> conninfos;                          // of each attempt, in order
+    std::vector<std::shared_ptr<basic_connection>> attempts;
+    size_t num_resolving{};
+    size_t num_connecting{};
+    size_t next{};
+    error_code ec;
+    bool is_done{};
+  };
+
+  void async_connect_resolved_erased(
+    std::string conninfo,
+    std::chrono::steady_clock::duration attempt_delay,
+    asio::any_completion_handler<void(error_code)> handler)
+  {
+    char* errmsg = nullptr;
+    auto options =
+      std::unique_ptr<PQconninfoOption, conninfo_options_deleter>{ PQconninfoParse(conninfo.data(), &errmsg) };
+    if (errmsg)
+      PQfreemem(errmsg);
+
+    if (!options)
+      return asio::post(asio::append(std::move(handler), error::invalid_conninfo));
+
+    auto race        = std::make_shared<connect_race>(socket_.get_executor(), attempt_delay, std::move(handler));
+    auto is_resolved = false;
+
+    for (auto* option = options.get(); option->keyword; option++)
+    {
+      if (!option->val)
+        continue;
+
+      const auto keyword = std::string_view{ option->keyword };
+      if (keyword == "host")
+        race->hosts = split_conninfo_list(option->val);
+      else if (keyword == "port")
+        race->ports = split_conninfo_list(option->val);
+      else if (keyword == "hostaddr")
+        is_resolved = *option->val != '\0';
+      else
+        append_conninfo_option(race->common_conninfo, keyword, option->val);
+    }
+
+    const auto is_socket_path = [](std::string_view host) { return host.starts_with('/') || host.starts_with('@'); };
+
+    if (is_resolved || race->hosts.empty() || std::ranges::any_of(race->hosts, is_socket_path) ||
+        (race->ports.size() > 1 && race->ports.size() != race->hosts.size()))
+      return async_connect(std::move(conninfo), std::move(race->handler));
+
+    race->endpoints.resize(race->hosts.size());
+    race->num_resolving = race->hosts.size();
+
+    for (size_t i = 0; i < race->hosts.size(); i++)
+    {
+      race->resolver.async_resolve(
+        race->hosts[i],
+        port_of_host(*race, i),
+        [this, race, i](error_code ec, typename connect_race::resolver_type::results_type results)
+        {
+          if (ec)
+            race->ec = ec;
+
+          for (const auto& entry : results)
+            race->endpoints[i].push_back(entry.endpoint());
+
+          if (--race->num_resolving == 0)
+            start_connect_race(race);
+        });
+    }
+  }
+
+  void start_connect_race(const std::shared_ptr<connect_race>& race)
+  {
+    // Addresses are tried in the order of the hosts, and in the order of resolution within each host. The name of the
+    // host is kept in the attempts, as libpq verifies the server certificate and authenticates against it.
+    for (size_t i = 0; i < race->hosts.size(); i++)
+    {
+      for (const auto& endpoint : race->endpoints[i])
+      {
+        auto conninfo = race->common_conninfo;
+        append_conninfo_option(conninfo, "host", race->hosts[i]);
+        append_conninfo_option(conninfo, "hostaddr", endpoint.address().to_string());
+        append_conninfo_option(conninfo, "port", std::to_string(endpoint.port()));
+        race->conninfos.push_back(std::move(conninfo));
+      }
+    }
+
+    if (race->conninfos.empty())
+    {
+      race->is_done = true;
+      return asio::post(
+        asio::append(std::move(race->handler), race->ec ? race->ec : error_code{ error::connection_failed }));
+    }
+
+    start_connect_attempt(race);
+  }
+
+  void start_connect_attempt(const std::shared_ptr<connect_race>& race)
+  {
+    auto attempt = std::make_shared<basic_connection>(socket_.get_executor());
+    race->attempts.push_back(attempt);
+    race->num_connecting++;
+    attempt->async_connect(
+      race->conninfos[race->next++],
+      [this, race, attempt](error_code ec) { on_connect_attempt(race, *attempt, ec); });
+
+    if (race->next < race->conninfos.size())
+    {
+      race->timer.expires_after(race->attempt_delay);
+      race->timer.async_wait(
+        [this, race](error_code ec)
+        {
+          if (!ec && !race->is_done)
+            start_connect_attempt(race);
+        });
+    }
+  }
+
+  void on_connect_attempt(const std::shared_ptr<connect_race>& race, basic_connection& attempt, error_code ec)
+  {
+    race->num_connecting--;
+
+    if (race->is_done)
+      return;
+
+    if (ec)
+    {
+      race->ec = ec;
+
+      // A failed attempt doesn't wait for the delay to pass before the next one starts.
+      if (race->next < race->conninfos.size())
+        return start_connect_attempt(race);
+
+      if (race->num_connecting != 0)
+        return;
+    }
+
+    race->is_done = true;
+    race->timer.cancel();
+    adopt(attempt);
+
+    // The attempts that are still in progress complete with operation_aborted and are ignored.
+    for (const auto& other : race->attempts)
+      other->close();
+
+    asio::post(asio::append(std::move(race->handler), ec));
+  }
+
+  // Takes over the libpq connection of another basic_connection, with its socket.
+  void adopt(basic_connection& other) noexcept
+  {
+    close();
+    pgconn_ = std::move(other.pgconn_);
+    socket_ = std::move(other.socket_);
+  }
+
+  std::string port_of_host(const connect_race& race, size_t index) const
+  {
+    if (index < race.ports.size() && !race.ports[index].empty())
+      return race.ports[index];
+    if (race.ports.size() == 1 && !race.ports.front().empty())
+      return race.ports.front();
+    if (const auto* env = std::getenv("PGPORT"))
+      return env;
+    return "5432";
+  }
+
+  static std::vector<std::string> split_conninfo_list(std::string_view list)
+  {
+    auto items = std::vector<std::string>{};
+    for (const auto item : std::views::split(list, ','))
+      items.emplace_back(item.begin(), item.end());
+    return items;
+  }
+
+  static void append_conninfo_option(std::string& conninfo, std::string_view keyword, std::string_view value)
+  {
+    conninfo.append(keyword).append("='");
+    for (char c : value)
+    {
+      if (c == '\'' || c == '\\')
+        conninfo += '\\';
+      conninfo += c;
+    }
+    conninfo.append("' ");
   }
 
-  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
-  auto async_describe_portal(std::string portal_name, CompletionToken&& token = CompletionToken{})
+  // Binds the recycled operation storage of the connection to completion tokens without an allocator of their own.
+  template<typename CompletionToken>
+  decltype(auto) with_handler_memory(CompletionToken&& token)
   {
-    return asio::async_compose<CompletionToken, void(error_code, result)>(
-      [this, coro = asio::coroutine{}, portal_name = std::move(portal_name)](
-        auto& self, error_code ec = {}, result result = {}) mutable
-      {
-        BOOST_ASIO_CORO_REENTER(coro)
-        {
-          if (!PQsendDescribePortal(pgconn_.get(), portal_name.data()))
-            return self.complete(error::pq_send_describe_portal_failed, {});
+    if constexpr (std::is_same_v<asio::associated_allocator_t<std::decay_t<CompletionToken>>, std::allocator<void>>)
+      return asio::bind_allocator(
+        detail::handler_allocator<void>{ handler_memory_ }, std::forward<CompletionToken>(token));
+    else
+      return std::forward<CompletionToken>(token);
+  }
 
-          BOOST_ASIO_CORO_YIELD async_generic_single_result_query(std::move(self));
-          return self.complete(ec, std::move(result));
-        }
-      },
-      token,
-      socket_);
+  // Intermediate operations allocate through the associated allocator of the handler, so all of them reuse the
+  // memory of the connection.
+  template<typename Signature, typename CompletionToken, typename Implementation>
+  auto async_compose_recycled(Implementation&& implementation, CompletionToken&& token)
+  {
+    auto&& bound_token = with_handler_memory(std::forward<CompletionToken>(token));
+    return asio::async_compose<decltype(bound_token), Signature>(
+      std::forward<Implementation>(implementation), bound_token, socket_);
   }
 
-  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
-  auto async_receive_notifcation(CompletionToken&& token = CompletionToken{})
+  template<typename CompletionToken>
+  auto async_flush(CompletionToken&& token)
   {
-    return asio::async_compose<CompletionToken, void(error_code, notification)>(
-      [this, coro = asio::coroutine{}, stored_notification = notification{}, needs_rescheduling = true](
-        auto& self, error_code ec = {}) mutable
+    return async_compose_recycled<void(error_code)>(
+      [this](auto& self, error_code ec = {}, wait_type ready = wait_type::wait_write)
       {
-        if (ec && !(ec == asio::error::operation_aborted && !self.cancelled()))
-          return self.complete(ec, {});
-
-        BOOST_ASIO_CORO_REENTER(coro)
-        {
-          self.reset_cancellation_state(asio::enable_total_cancellation());
-
-          for (;;)
-          {
-            if ((stored_notification = notification{ PQnotifies(pgconn_.get()) }))
-            {
-              if (needs_rescheduling)
-              {
-                BOOST_ASIO_CORO_YIELD asio::post(std::move(self));
-              }
+        if (ec)
+          return self.complete(ec);
 
-              return self.complete({}, std::move(stored_notification));
-            }
+        // The server might not read our data until we read its, so input is consumed while waiting for the flush.
+        if (ready == wait_type::wait_read && !PQconsumeInput(pgconn_.get()))
+          return self.complete(error::pq_consume_input_failed);
 
-            if (asio::get_associated_cancellation_slot(self).is_connected())
-              asio::get_associated_cancellation_slot(self).assign([this](auto c) { notification_cs_->emit(c); });
+        const int ret = PQflush(pgconn_.get());
 
-            BOOST_ASIO_CORO_YIELD socket_.async_wait(
-              wait_type::wait_read, asio::bind_cancellation_slot(notification_cs_->slot(), std::move(self)));
+        if (ret == -1)
+          return self.complete(error::pq_flush_failed);
 
-            if (!PQconsumeInput(pgconn_.get()))
-              return self.complete(error::pq_consume_input_failed, {});
-          }
+        if (ret == 0)
+        {
+          trace_point(exchange_times_.sent);
+          return self.complete({});
         }
-      },
-      token,
-      socket_);
-  }
 
-  ~basic_connection()
-  {
-    // PQfinish handles the closing of the socket.
-    if (pgconn_)
-      socket_.release();
+        return async_wait_writable_or_readable(std::move(self));
+      },
+      std::forward<CompletionToken>(token));
   }
 
-private:
+  // Completes with the first of the two waits that succeeds and cancels the other one. The shared state is
+  // allocated with the associated allocator of the handler, unlike the one of a parallel_group.
   template<typename CompletionToken>
-  auto async_flush(CompletionToken&& token)
+  auto async_wait_writable_or_readable(CompletionToken&& token)
   {
-    return asio::async_compose<CompletionToken, void(error_code)>(
-      [this](auto& self, std::array<std::size_t, 2> order = {}, error_code ec1 = {}, error_code ec2 = {})
+    return asio::async_initiate<CompletionToken, void(error_code, wait_type)>(
+      [this](auto handler)
       {
-        if (order[0])
-        {
-          if (ec2)
-            return self.complete(ec2);
+        using handler_type = decltype(handler);
 
-          if (!PQconsumeInput(pgconn_.get()))
-            return self.complete(error::pq_consume_input_failed);
-        }
-        else
+        struct state
         {
-          if (ec1)
-            return self.complete(ec1);
+          explicit state(handler_type h)
+            : handler{ std::move(h) }
+          {
+          }
 
-          const int ret = PQflush(pgconn_.get());
+          handler_type handler;
+          std::array<asio::cancellation_signal, 2> signals{};
+          std::atomic<int> num_pending{ 2 };
+          std::atomic<bool> is_decided{};
+          error_code ec{};
+          wait_type ready{};
+        };
 
-          if (ret == -1)
-            return self.complete(error::pq_flush_failed);
+        using alloc_type = typename std::allocator_traits<
+          asio::associated_allocator_t<handler_type>>::template rebind_alloc<state>;
 
-          if (ret == 0)
-            return self.complete({});
+        auto alloc = alloc_type{ asio::get_associated_allocator(handler) };
+        auto* st   = std::allocator_traits<alloc_type>::allocate(alloc, 1);
+        std::allocator_traits<alloc_type>::construct(alloc, st, std::move(handler));
+
+        if (auto slot = asio::get_associated_cancellation_slot(st->handler); slot.is_connected())
+        {
+          slot.assign(
+            [st](asio::cancellation_type type)
+            {
+              for (auto& signal : st->signals)
+                signal.emit(type);
+            });
         }
 
-        return asio::experimental::make_parallel_group(
-                 [this](auto token) { return socket_.async_wait(wait_type::wait_write, token); },
-                 [this](auto token) { return socket_.async_wait(wait_type::wait_read, token); })
-          .async_wait(asio::experimental::wait_for_one{}, std::move(self));
+        const auto exec = asio::get_associated_executor(st->handler, socket_.get_executor());
+
+        for (auto i : { 0, 1 })
+        {
+          const auto wait = i == 0 ? wait_type::wait_write : wait_type::wait_read;
+          socket_.async_wait(
+            wait,
+            asio::bind_cancellation_slot(
+              st->signals[i].slot(),
+              asio::bind_executor(
+                exec,
+                asio::bind_allocator(
+                  asio::get_associated_allocator(st->handler),
+                  [st, i, wait](error_code ec)
+                  {
+                    if (!st->is_decided.exchange(true))
+                    {
+                      st->ec    = ec;
+                      st->ready = wait;
+                      st->signals[1 - i].emit(asio::cancellation_type::total);
+                    }
+
+                    if (--st->num_pending != 0)
+                      return;
+
+                    // The state is freed before the upcall, so its memory can be reused by the next operation.
+                    asio::get_associated_cancellation_slot(st->handler).clear();
+                    auto handler = std::move(st->handler);
+                    auto args    = std::tuple{ st->ec, st->ready };
+                    auto alloc   = alloc_type{ asio::get_associated_allocator(handler) };
+                    std::allocator_traits<alloc_type>::destroy(alloc, st);
+                    std::allocator_traits<alloc_type>::deallocate(alloc, st, 1);
+                    std::apply(std::move(handler), std::move(args));
+                  }))));
+        }
       },
-      token,
-      socket_);
+      token);
   }
 
   template<typename CompletionToken>
   auto async_receive_result(CompletionToken&& token)
   {
-    return asio::async_compose<CompletionToken, void(error_code, result)>(
-      [this, coro = asio::coroutine{}, needs_rescheduling = true](auto& self, error_code ec = {}) mutable
+    return async_compose_recycled<void(error_code, result)>(
+      [this, coro = asio::coroutine{}, needs_rescheduling = true, is_cancel_requested = false](
+        auto& self, error_code ec = {}) mutable
       {
-        if (ec)
+        if (ec && !(ec == asio::error::operation_aborted && self.cancelled() != asio::cancellation_type::none &&
+                    !is_cancel_requested))
+        {
+          if (is_cancel_requested)
+            receive_cancellation_->grace_timer.cancel();
           return self.complete(ec, {});
+        }
 
         BOOST_ASIO_CORO_REENTER(coro)
         {
           while (PQisBusy(pgconn_.get()))
           {
             needs_rescheduling = false;
-            BOOST_ASIO_CORO_YIELD socket_.async_wait(wait_type::wait_read, std::move(self));
+
+            if (!is_cancel_requested)
+            {
+              BOOST_ASIO_CORO_YIELD socket_.async_wait(wait_type::wait_read, std::move(self));
+            }
+            else
+            {
+              // Only this wait is abandoned, the other waits on the socket, such as the one of
+              // async_receive_notifications, carry on.
+              asio::get_associated_cancellation_slot(self).assign(
+                [rc = receive_cancellation_.get()](auto c) { rc->signal.emit(c); });
+              BOOST_ASIO_CORO_YIELD socket_.async_wait(
+                wait_type::wait_read,
+                asio::bind_cancellation_slot(receive_cancellation_->signal.slot(), std::move(self)));
+            }
+
+            // The operation has been cancelled: the query is cancelled on the server, and its result is still
+            // received, so the connection is left idle instead of busy with a query nobody waits for. The wait is
+            // bounded by the grace period, after which the wait, or a further cancellation, abandons the query.
+            if (ec)
+            {
+              is_cancel_requested = true;
+              async_cancel(asio::detached);
+              arm_cancel_grace_timer();
+              continue;
+            }
+
             if (!PQconsumeInput(pgconn_.get()))
+            {
+              if (is_cancel_requested)
+                receive_cancellation_->grace_timer.cancel();
               return self.complete(error::pq_consume_input_failed, {});
+            }
+
+            if (tracer_ && exchange_times_.first_byte < exchange_times_.sent)
+              exchange_times_.first_byte = std::chrono::steady_clock::now();
           }
 
+          if (is_cancel_requested)
+            receive_cancellation_->grace_timer.cancel();
+
           if (needs_rescheduling)
           {
             BOOST_ASIO_CORO_YIELD asio::post(socket_.get_executor(), std::move(self));
           }
 
-          return self.complete({}, result{ PQgetResult(pgconn_.get()) });
+          {
+            const auto last_byte = tracer_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            auto res             = result{ PQgetResult(pgconn_.get()) };
+            if (res)
+            {
+              detail::increment(metrics_->bytes_received, PQresultMemorySize(res.native_handle()));
+
+              // The results that end a query or a sync segment don't belong to the response of a query.
+              if (tracer_ && PQresultStatus(res.native_handle()) != PGRES_PIPELINE_SYNC)
+              {
+                exchange_times_.last_byte = last_byte;
+                exchange_times_.decoded   = std::chrono::steady_clock::now();
+              }
+            }
+            return self.complete({}, std::move(res));
+          }
         }
       },
-      token,
-      socket_);
+      std::forward<CompletionToken>(token));
+  }
+
+  void arm_cancel_grace_timer()
+  {
+    auto* rc = receive_cancellation_.get();
+    auto id  = ++rc->id;
+
+    rc->grace_timer.expires_after(cancel_grace_period_);
+    rc->grace_timer.async_wait(
+      [rc, id](error_code ec)
+      {
+        // The timer is destroyed along with the connection, which aborts the wait before rc would dangle.
+        if (!ec && id == rc->id)
+          rc->signal.emit(asio::cancellation_type::terminal);
+      });
   }
 
   auto async_query_oids_erased(asio::any_completion_handler<void(error_code)> handler)
   {
+    // The operation takes the pending types, so concurrent operations can collect their own.
     return asio::async_compose<decltype(handler), void(error_code)>(
-      [this, coro = asio::coroutine{}](auto& self, error_code ec = {}, result result = {}) mutable
+      [this, coro = asio::coroutine{}, new_udts = std::exchange(new_udts_, {})](
+        auto& self, error_code ec = {}, result result = {}) mutable
       {
         if (ec)
           return self.complete(ec);
 
         BOOST_ASIO_CORO_REENTER(coro)
         {
+          if (oid_cache_)
+            oid_cache_->lookup(new_udts, oid_map_);
+
+          if (new_udts.empty())
+          {
+            BOOST_ASIO_CORO_YIELD asio::post(socket_.get_executor(), std::move(self));
+            return self.complete({});
+          }
+
+          if (!enter_auto_pipeline_mode())
+            return self.complete(error::pq_enter_pipeline_mode_failed);
+
           {
             std::vector<std::string_view> new_udt_names;
-            new_udt_names.reserve(new_udts_.size());
-            for (const auto& [name, _] : new_udts_)
+            new_udt_names.reserve(new_udts.size());
+            for (const auto& [name, _] : new_udts)
               new_udt_names.push_back(name);
 
             auto [t, v, l, f] = detail::serialize(oid_map_, buffer_, mp(new_udt_names));
@@ -503,7 +2024,9 @@ private:
             if (type_oid == 0xFFFFFFFF || array_oid == 0xFFFFFFFF)
               return self.complete(error::user_defined_type_does_not_exist);
 
-            oid_map_.emplace(new_udts_.at(i).type_index, detail::oid_pair{ type_oid, array_oid });
+            oid_map_.emplace(new_udts.at(i).slot, detail::oid_pair{ type_oid, array_oid });
+            if (oid_cache_)
+              oid_cache_->insert(new_udts.at(i).slot, detail::oid_pair{ type_oid, array_oid });
           }
 
           return self.complete({});
@@ -520,8 +2043,126 @@ private:
       [this](auto handler) { async_query_oids_erased(std::move(handler)); }, token);
   }
 
+  bool is_auto_pipeline_active() const noexcept
+  {
+    return auto_pipelining_ && PQpipelineStatus(pgconn_.get()) == PQ_PIPELINE_ON;
+  }
+
+  // The operations that read the result stream on their own can't share it with the queries of an auto-pipeline, or
+  // of any other pipeline in progress.
+  bool is_pipeline_in_use() const noexcept
+  {
+    return is_auto_pipeline_running_ || PQpipelineStatus(pgconn_.get()) != PQ_PIPELINE_OFF;
+  }
+
+  // Ends the sync segment of the queries that have been sent and queues the handler for its result.
+  void enqueue_auto_pipelined(asio::any_completion_handler<void(error_code, result)> handler)
+  {
+    if (!PQpipelineSync(pgconn_.get()))
+      return asio::post(asio::append(std::move(handler), error::pq_pipeline_sync_failed, result{}));
+
+    // Sends the query right away, so it doesn't wait for the results of the previous ones.
+    if (PQflush(pgconn_.get()) == -1)
+      return asio::post(asio::append(std::move(handler), error::pq_flush_failed, result{}));
+
+    if (auto_pipeline_handlers_.full())
+      auto_pipeline_handlers_.set_capacity(std::max<size_t>(16, auto_pipeline_handlers_.capacity() * 2));
+    auto_pipeline_handlers_.push_back(std::move(handler));
+
+    if (!std::exchange(is_auto_pipeline_running_, true))
+      async_run_auto_pipeline(asio::detached);
+  }
+
+  // Sends the deallocation of each evicted statement in its own sync segment, so a statement that no longer exists
+  // doesn't abort anything else. Must be called in pipeline mode.
+  bool send_statement_deallocations(size_t& num_segments)
+  {
+    for (const auto& stmt_name : statement_cache_.take_evicted())
+    {
+#ifdef LIBPQ_HAS_CLOSE_PREPARED
+      if (!PQsendClosePrepared(pgconn_.get(), stmt_name.data()))
+        return false;
+#else
+      const auto query = "DEALLOCATE " + stmt_name;
+      if (!PQsendQueryParams(pgconn_.get(), query.data(), 0, nullptr, nullptr, nullptr, nullptr, 1))
+        return false;
+#endif
+      if (is_auto_pipeline_active())
+      {
+        enqueue_auto_pipelined(asio::bind_executor(socket_.get_executor(), [](error_code, result) {}));
+      }
+      else
+      {
+        if (!PQpipelineSync(pgconn_.get()))
+          return false;
+        num_segments++;
+      }
+    }
+    return true;
+  }
+
+  // Completes with the result of the last of the sync segments that have been sent in pipeline mode; the last segment
+  // is ended here. Leaves pipeline mode afterwards unless auto-pipelining is active.
+  void async_generic_pipelined_query_erased(
+    size_t num_segments,
+    asio::any_completion_handler<void(error_code, result)> handler)
+  {
+    if (is_auto_pipeline_active())
+      return enqueue_auto_pipelined(std::move(handler));
+
+    return asio::async_compose<decltype(handler), void(error_code, result)>(
+      [this, coro = asio::coroutine{}, num_segments, stored_result = result{}](
+        auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        if (ec)
+          return self.complete(ec, {});
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if (!PQpipelineSync(pgconn_.get()))
+            return self.complete(error::pq_pipeline_sync_failed, {});
+
+          BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+
+          while (num_segments--)
+          {
+            stored_result = {};
+            for (;;)
+            {
+              BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+              if (PQresultStatus(result.native_handle()) == PGRES_PIPELINE_SYNC)
+                break;
+              merge_sync_segment_result(stored_result, std::move(result));
+            }
+          }
+
+          if (!PQexitPipelineMode(pgconn_.get()))
+            return self.complete(error::pq_exit_pipeline_mode_failed, {});
+
+          notification_cs_->emit(asio::cancellation_type::terminal);
+          auto result_ec = result_status_to_error_code(stored_result);
+          return self.complete(result_ec, std::move(stored_result));
+        }
+      },
+      handler,
+      socket_);
+  }
+
+  template<typename CompletionToken>
+  auto async_generic_pipelined_query(size_t num_segments, CompletionToken&& token)
+  {
+    return asio::async_initiate<CompletionToken, void(error_code, result)>(
+      [this](auto handler, size_t num_segments)
+      { async_generic_pipelined_query_erased(num_segments, std::move(handler)); },
+      token,
+      num_segments);
+  }
+
   void async_generic_single_result_query_erased(asio::any_completion_handler<void(error_code, result)> handler)
   {
+    if (is_auto_pipeline_active())
+      return enqueue_auto_pipelined(std::move(handler));
+
     return asio::async_compose<decltype(handler), void(error_code, result)>(
       [this, coro = asio::coroutine{}, stored_result = result{}](
         auto& self, error_code ec = {}, result result = {}) mutable
@@ -556,11 +2197,217 @@ private:
       [this](auto handler) { async_generic_single_result_query_erased(std::move(handler)); }, token);
   }
 
+  bool enter_auto_pipeline_mode() noexcept
+  {
+    return !auto_pipelining_ || PQenterPipelineMode(pgconn_.get());
+  }
+
+  // Reads the results of the auto-pipelined queries and completes their operations in order, until no query is in
+  // flight.
+  template<typename CompletionToken>
+  auto async_run_auto_pipeline(CompletionToken&& token)
+  {
+    return async_compose_recycled<void(error_code)>(
+      [this, coro = asio::coroutine{}, stored_result = result{}](
+        auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        if (ec)
+        {
+          is_auto_pipeline_running_ = false;
+          for (auto& handler : auto_pipeline_handlers_)
+            asio::post(asio::append(std::move(handler), ec, psql::result{}));
+          auto_pipeline_handlers_.clear();
+          return self.complete(ec);
+        }
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          while (!auto_pipeline_handlers_.empty())
+          {
+            // Flushes what remained in libpq's buffer from the queries pushed while waiting for results.
+            BOOST_ASIO_CORO_YIELD async_flush(std::move(self));
+
+            for (;;)
+            {
+              BOOST_ASIO_CORO_YIELD async_receive_result(std::move(self));
+              if (PQresultStatus(result.native_handle()) == PGRES_PIPELINE_SYNC)
+                break;
+              merge_sync_segment_result(stored_result, std::move(result));
+            }
+
+            {
+              auto handler = std::move(auto_pipeline_handlers_.front());
+              auto_pipeline_handlers_.pop_front();
+              notification_cs_->emit(asio::cancellation_type::terminal);
+              auto result_ec = result_status_to_error_code(stored_result);
+              asio::dispatch(asio::append(std::move(handler), result_ec, std::move(stored_result)));
+            }
+          }
+
+          is_auto_pipeline_running_ = false;
+
+          if (!PQexitPipelineMode(pgconn_.get()))
+            return self.complete(error::pq_exit_pipeline_mode_failed);
+
+          return self.complete({});
+        }
+      },
+      std::forward<CompletionToken>(token));
+  }
+
+  // Keeps the result that represents a sync segment: the first failed result, otherwise the last one.
+  static void merge_sync_segment_result(result& stored_result, result&& result) noexcept
+  {
+    if (result && (!stored_result || !result_status_to_error_code(stored_result)))
+      stored_result = std::move(result);
+  }
+
+  void trace_point(std::chrono::steady_clock::time_point& point) const noexcept
+  {
+    if (tracer_)
+      point = std::chrono::steady_clock::now();
+  }
+
+  // Completes the trace of a query with the times of the last exchange, and hands it to the tracer. Missing phases,
+  // and times left from earlier exchanges, are clamped to the end of the previous phase.
+  void finish_trace(
+    query_trace& trace,
+    std::string_view query,
+    std::chrono::steady_clock::time_point start,
+    error_code ec,
+    const result& result) const
+  {
+    if (!tracer_)
+      return;
+
+    trace.query          = query;
+    trace.start          = start;
+    trace.sent           = exchange_times_.sent;
+    trace.first_byte     = exchange_times_.first_byte;
+    trace.last_byte      = exchange_times_.last_byte;
+    trace.decoded        = exchange_times_.decoded;
+    trace.completed      = std::chrono::steady_clock::now();
+    trace.bytes_received = result ? PQresultMemorySize(result.native_handle()) : 0;
+    trace.num_rows       = result.size();
+    trace.ec             = ec;
+
+    auto previous = start;
+    for (auto* point : { &trace.udts_resolved,
+                         &trace.serialized,
+                         &trace.sent,
+                         &trace.first_byte,
+                         &trace.last_byte,
+                         &trace.decoded,
+                         &trace.completed })
+      previous = *point = std::max(*point, previous);
+
+    tracer_->on_query(trace);
+  }
+
+  // Reports a query that failed before its results were received to the tracer and the metrics.
+  error_code finish_failed_query(
+    query_trace& trace,
+    std::string_view query,
+    std::chrono::steady_clock::time_point start,
+    error_code ec)
+  {
+    finish_trace(trace, query, start, ec, {});
+    return finish_operation(start, ec);
+  }
+
+  // Records the metrics of a completed operation, and forgets the known Oids if the error suggests they're stale.
+  error_code finish_operation(std::chrono::steady_clock::time_point start, error_code ec)
+  {
+    metrics_->operation_latency.record_since(start);
+    detail::increment(metrics_->num_operations);
+
+    if (ec)
+    {
+      detail::increment(metrics_->num_failed_operations);
+
+      if (is_stale_oid_error(ec))
+      {
+        oid_map_.clear();
+        if (oid_cache_)
+          oid_cache_->clear();
+        sync_oid_map();
+      }
+    }
+
+    return ec;
+  }
+
+  // The errors the server reports for binary values of types that have been dropped or recreated, e.g. "cache lookup
+  // failed for type 16385" or "type with OID 16385 does not exist". The same SQLSTATEs are raised by plenty of
+  // unrelated queries, so they only count when the message names the Oid of a user-defined type this connection sent.
+  bool is_stale_oid_error(error_code ec) const
+  {
+    if (oid_map_.empty())
+      return false;
+
+    const auto message = std::string_view{ PQerrorMessage(pgconn_.get()) };
+
+    const auto names_known_oid = [&](std::string_view prefix)
+    {
+      const auto pos = message.find(prefix);
+      if (pos == std::string_view::npos)
+        return false;
+
+      auto oid            = uint32_t{};
+      const auto* first   = message.data() + pos + prefix.size();
+      const auto [_, err] = std::from_chars(first, message.data() + message.size(), oid);
+      return err == std::errc{} && oid_map_.contains_oid(oid);
+    };
+
+    if (ec == sqlstate::internal_error)
+      return names_known_oid("cache lookup failed for type ");
+
+    if (ec == sqlstate::undefined_object)
+      return names_known_oid("type with OID ");
+
+    // A composite or array value whose member types were sent with Oids that have changed since.
+    if (ec == sqlstate::datatype_mismatch)
+      return names_known_oid("wrong data type: ");
+
+    return false;
+  }
+
+  // Forgets the local copies of the Oids once the shared cache has been cleared, e.g. by another connection of the
+  // pool that ran into a stale Oid, so this connection doesn't have to fail on it once more.
+  void sync_oid_map() noexcept
+  {
+    if (!oid_cache_)
+      return;
+
+    if (const auto generation = oid_cache_->generation(); generation != oid_cache_generation_)
+    {
+      oid_map_.clear();
+      oid_cache_generation_ = generation;
+    }
+  }
+
+  static bool is_partial_tuples_result(const result& result) noexcept
+  {
+    switch (PQresultStatus(result.native_handle()))
+    {
+      case PGRES_SINGLE_TUPLE:
+#ifdef LIBPQ_HAS_CHUNK_MODE
+      case PGRES_TUPLES_CHUNK:
+#endif
+        return true;
+      default:
+        return false;
+    }
+  }
+
   static error_code result_status_to_error_code(const result& result) noexcept
   {
     switch (PQresultStatus(result.native_handle()))
     {
       case PGRES_SINGLE_TUPLE:
+#ifdef LIBPQ_HAS_CHUNK_MODE
+      case PGRES_TUPLES_CHUNK:
+#endif
       case PGRES_TUPLES_OK:
       case PGRES_COMMAND_OK:
         return {};
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <psql/connection.hpp>
+#include <psql/metrics.hpp>
 
 #include <boost/asio/steady_timer.hpp>
 
+#include <chrono>
+#include <deque>
 #include <mutex>
-#include <queue>
+#include <random>
 
 namespace psql
 {
@@ -15,12 +18,14 @@ template<typename Executor>
 class basic_connection_pool_impl;
 } // namespace detail
 
-template<typename Executor = asio::any_io_executor>
+template<typename Executor = asio::any_io_executor, typename PoolImpl = detail::basic_connection_pool_impl<Executor>>
 class basic_pooled_connection
 {
-  using conn_pool_pointer_type = std::weak_ptr<detail::basic_connection_pool_impl<Executor>>;
+  using conn_pool_pointer_type = std::weak_ptr<PoolImpl>;
+  using time_point             = std::chrono::steady_clock::time_point;
   conn_pool_pointer_type conn_pool_;
   basic_connection<Executor> conn_;
+  time_point expires_at_{ time_point::max() };
 
 public:
   explicit basic_pooled_connection(Executor exec)
@@ -28,9 +33,13 @@ public:
   {
   }
 
-  basic_pooled_connection(conn_pool_pointer_type conn_pool, basic_connection<Executor> conn)
+  basic_pooled_connection(
+    conn_pool_pointer_type conn_pool,
+    basic_connection<Executor> conn,
+    time_point expires_at = time_point::max())
     : conn_pool_{ std::move(conn_pool) }
     , conn_{ std::move(conn) }
+    , expires_at_{ expires_at }
   {
   }
 
@@ -42,6 +51,7 @@ public:
   {
     std::swap(conn_pool_, other.conn_pool_);
     std::swap(conn_, other.conn_);
+    std::swap(expires_at_, other.expires_at_);
     return *this;
   }
 
@@ -64,21 +74,47 @@ template<typename Executor>
 class basic_connection_pool_impl : public std::enable_shared_from_this<basic_connection_pool_impl<Executor>>
 {
   using error_code = boost::system::error_code;
+  using clock_type = std::chrono::steady_clock;
+
+  struct idle_connection
+  {
+    basic_connection<Executor> conn;
+    clock_type::time_point idle_since;
+    clock_type::time_point expires_at;
+  };
+
+  struct warm_up_state
+  {
+    size_t pending{};
+    error_code ec;
+    asio::any_completion_handler<void(error_code)> handler;
+  };
 
   std::mutex mtx_;
   Executor exec_;
   asio::steady_timer cv_;
+  asio::steady_timer reaper_;
+  std::minstd_rand rng_{ std::random_device{}() };
   std::string conninfo_;
   size_t max_size_{};
+  size_t min_size_{};
   size_t aquired_conns_{};
-  std::queue<basic_connection<Executor>> idle_conns_;
+  size_t connecting_conns_{}; // idle connections being opened in the background
+  size_t statement_cache_capacity_{};
+  clock_type::duration idle_timeout_{};
+  clock_type::duration max_lifetime_{};
+  clock_type::duration connect_attempt_delay_{};
+  std::deque<idle_connection> idle_conns_; // most recently returned last
+  detail::pool_metrics_recorder metrics_;
+  const std::shared_ptr<oid_cache> oid_cache_ = std::make_shared<oid_cache>();
 
 public:
   using executor_type = Executor;
 
   basic_connection_pool_impl(Executor exec, std::string conninfo, size_t max_size = 32)
     : exec_{ exec }
-    , cv_{ std::move(exec), asio::steady_timer::time_point::max() }
+    , cv_{ exec, asio::steady_timer::time_point::max() }
+    , reaper_{ std::move(exec) }
     , conninfo_{ std::move(conninfo) }
     , max_size_{ max_size }
   {
@@ -102,18 +138,105 @@ public:
     cv_.cancel();
   }
 
+  size_t min_size() noexcept
+  {
+    auto lg = std::lock_guard<std::mutex>{ mtx_ };
+    return min_size_;
+  }
+
+  void min_size(size_t value)
+  {
+    auto lg   = std::unique_lock<std::mutex>{ mtx_ };
+    min_size_ = value;
+    auto n    = reserve_idle_connections();
+    lg.unlock();
+    open_idle_connections(n);
+  }
+
   size_t num_aquired() noexcept
   {
     auto lg = std::lock_guard<std::mutex>{ mtx_ };
     return aquired_conns_;
   }
 
+  size_t num_idle() noexcept
+  {
+    auto lg = std::lock_guard<std::mutex>{ mtx_ };
+    return idle_conns_.size();
+  }
+
+  pool_metrics metrics() noexcept
+  {
+    auto lg = std::lock_guard<std::mutex>{ mtx_ };
+    return metrics_.snapshot(aquired_conns_, idle_conns_.size());
+  }
+
+  size_t statement_cache_capacity() noexcept
+  {
+    auto lg = std::lock_guard<std::mutex>{ mtx_ };
+    return statement_cache_capacity_;
+  }
+
+  void statement_cache_capacity(size_t value) noexcept
+  {
+    auto lg                   = std::lock_guard<std::mutex>{ mtx_ };
+    statement_cache_capacity_ = value;
+  }
+
+  const std::shared_ptr<oid_cache>& shared_oid_cache() const noexcept
+  {
+    return oid_cache_;
+  }
+
+  clock_type::duration idle_timeout() noexcept
+  {
+    auto lg = std::lock_guard<std::mutex>{ mtx_ };
+    return idle_timeout_;
+  }
+
+  void idle_timeout(clock_type::duration value)
+  {
+    auto lg       = std::lock_guard<std::mutex>{ mtx_ };
+    idle_timeout_ = value;
+    schedule_reaper();
+  }
+
+  clock_type::duration max_lifetime() noexcept
+  {
+    auto lg = std::lock_guard<std::mutex>{ mtx_ };
+    return max_lifetime_;
+  }
+
+  void max_lifetime(clock_type::duration value)
+  {
+    auto lg       = std::lock_guard<std::mutex>{ mtx_ };
+    max_lifetime_ = value;
+    schedule_reaper();
+  }
+
+  clock_type::duration connect_attempt_delay() noexcept
+  {
+    auto lg = std::lock_guard<std::mutex>{ mtx_ };
+    return connect_attempt_delay_;
+  }
+
+  void connect_attempt_delay(clock_type::duration value) noexcept
+  {
+    auto lg                = std::lock_guard<std::mutex>{ mtx_ };
+    connect_attempt_delay_ = value;
+  }
+
   template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
   auto async_aquire(CompletionToken&& token = CompletionToken{})
   {
     return asio::async_compose<CompletionToken, void(error_code, basic_pooled_connection<executor_type>)>(
-      [this, coro = asio::coroutine{}, conn = std::make_unique<basic_connection<Executor>>(exec_)](
-        auto& self, error_code ec = {}) mutable
+      [this,
+       coro          = asio::coroutine{},
+       conn          = std::make_unique<basic_connection<Executor>>(exec_),
+       expires_at    = clock_type::time_point::max(),
+       n             = size_t{},
+       start         = clock_type::now(),
+       connect_start = clock_type::time_point{}](auto& self, error_code ec = {}) mutable
       {
         auto lg = std::unique_lock<std::mutex>{ mtx_ };
 
@@ -121,10 +244,11 @@ public:
         {
           self.reset_cancellation_state(asio::enable_total_cancellation());
 
-          while (aquired_conns_ >= max_size_)
+          while (aquired_conns_ + connecting_conns_ >= max_size_)
           {
             if ((ec && ec != asio::error::operation_aborted) || !!self.cancelled())
             {
+              detail::increment(metrics_.local().num_aquire_cancellations);
               lg.unlock();
               return self.complete(ec, { {}, std::move(*conn) });
             }
@@ -134,48 +258,274 @@ public:
 
           aquired_conns_++;
 
+          // Connections that outlived max_lifetime since the last reaping are dropped here.
+          while (!idle_conns_.empty() && idle_conns_.back().expires_at <= clock_type::now())
+          {
+            idle_conns_.pop_back();
+            detail::increment(metrics_.local().num_expired);
+          }
+
           if (idle_conns_.empty())
           {
-            BOOST_ASIO_CORO_YIELD conn->async_connect(conninfo_, std::move(self));
+            conn->statement_cache_capacity(statement_cache_capacity_);
+            conn->shared_oid_cache(oid_cache_);
+            connect_start = clock_type::now();
+            BOOST_ASIO_CORO_YIELD async_connect(*conn, connect_attempt_delay_, std::move(self));
+            metrics_.local().connect_latency.record_since(connect_start);
+            if (ec)
+              detail::increment(metrics_.local().num_connect_failures);
+            expires_at = next_expiry();
           }
           else
           {
-            *conn = std::move(idle_conns_.front());
-            idle_conns_.pop();
+            // Reuses the most recently returned connection, which lets surplus ones age out with idle_timeout.
+            *conn      = std::move(idle_conns_.back().conn);
+            expires_at = idle_conns_.back().expires_at;
+            idle_conns_.pop_back();
+            n = reserve_idle_connections();
             BOOST_ASIO_CORO_YIELD asio::post(std::move(self));
           }
 
+          metrics_.local().aquire_wait.record_since(start);
+          detail::increment(metrics_.local().num_aquires);
+
           lg.unlock();
-          return self.complete(ec, { this->weak_from_this(), std::move(*conn) });
+          open_idle_connections(n);
+          return self.complete(ec, { this->weak_from_this(), std::move(*conn), expires_at });
         }
       },
       token,
       exec_);
   }
 
-  void return_connection(basic_connection<Executor>&& conn)
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_register_types(CompletionToken&& token = CompletionToken{})
   {
-    auto lg = std::lock_guard<std::mutex>{ mtx_ };
+    using pooled_connection_type = basic_pooled_connection<executor_type>;
+
+    return asio::async_compose<CompletionToken, void(error_code)>(
+      [this, coro = asio::coroutine{}, conn = std::optional<pooled_connection_type>{}](
+        auto& self, error_code ec = {}, std::optional<pooled_connection_type> aquired = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          BOOST_ASIO_CORO_YIELD async_aquire(std::move(self));
+          if (ec)
+            return self.complete(ec);
+
+          conn = std::move(aquired);
+          BOOST_ASIO_CORO_YIELD (*conn)->template async_register_types<Ts...>(std::move(self));
+          return self.complete(ec);
+        }
+      },
+      token,
+      exec_);
+  }
+
+  // Opens connections in parallel until there are min_size idle ones, completes with the first error if any fails.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_warm_up(CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_compose<CompletionToken, void(error_code)>(
+      [this, coro = asio::coroutine{}, n = size_t{}](auto& self, error_code ec = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          {
+            auto lg = std::lock_guard<std::mutex>{ mtx_ };
+            n       = reserve_idle_connections();
+          }
+
+          if (n == 0)
+          {
+            BOOST_ASIO_CORO_YIELD asio::post(std::move(self));
+          }
+          else
+          {
+            BOOST_ASIO_CORO_YIELD open_idle_connections(n, std::move(self));
+          }
+
+          return self.complete(ec);
+        }
+      },
+      token,
+      exec_);
+  }
+
+  void return_connection(basic_connection<Executor>&& conn, clock_type::time_point expires_at)
+  {
+    auto lg  = std::unique_lock<std::mutex>{ mtx_ };
+    auto now = clock_type::now();
 
     aquired_conns_--;
     cv_.cancel_one();
 
-    if (PQstatus(conn.native_handle()) != CONNECTION_OK)
+    if (PQstatus(conn.native_handle()) != CONNECTION_OK || PQtransactionStatus(conn.native_handle()) != PQTRANS_IDLE)
+      detail::increment(metrics_.local().num_discarded);
+    else if (expires_at <= now)
+      detail::increment(metrics_.local().num_expired);
+    else
+      return idle_conns_.push_back({ std::move(conn), now, expires_at });
+
+    // Replaces the discarded connection if it leaves the pool below min_size.
+    auto n = reserve_idle_connections();
+    lg.unlock();
+    open_idle_connections(n);
+  }
+
+private:
+  template<typename CompletionHandler>
+  void async_connect(basic_connection<Executor>& conn, clock_type::duration attempt_delay, CompletionHandler&& handler)
+  {
+    if (attempt_delay == clock_type::duration::zero())
+      conn.async_connect(conninfo_, std::forward<CompletionHandler>(handler));
+    else
+      conn.async_connect_resolved(conninfo_, attempt_delay, std::forward<CompletionHandler>(handler));
+  }
+
+  // Must be called with mtx_ held, returns the number of connections the caller must open with
+  // open_idle_connections after releasing the lock.
+  size_t reserve_idle_connections() noexcept
+  {
+    auto idle  = idle_conns_.size() + connecting_conns_;
+    auto total = idle + aquired_conns_;
+    auto n     = std::min(min_size_ > idle ? min_size_ - idle : 0, max_size_ > total ? max_size_ - total : 0);
+
+    connecting_conns_ += n;
+    return n;
+  }
+
+  void open_idle_connections(size_t n, asio::any_completion_handler<void(error_code)> handler = {})
+  {
+    if (n == 0)
       return;
 
-    if (PQtransactionStatus(conn.native_handle()) != PQTRANS_IDLE)
+    auto state = std::shared_ptr<warm_up_state>{};
+    if (handler)
+      state = std::make_shared<warm_up_state>(n, error_code{}, std::move(handler));
+
+    const auto attempt_delay = connect_attempt_delay();
+
+    for (size_t i = 0; i < n; i++)
+    {
+      auto conn = std::make_unique<basic_connection<Executor>>(exec_);
+      conn->statement_cache_capacity(statement_cache_capacity());
+      conn->shared_oid_cache(oid_cache_);
+
+      auto& conn_ref = *conn;
+      async_connect(
+        conn_ref,
+        attempt_delay,
+        [wp = this->weak_from_this(), conn = std::move(conn), state, start = clock_type::now()](error_code ec) mutable
+        {
+          if (auto sp = wp.lock())
+          {
+            sp->metrics_.local().connect_latency.record_since(start);
+            sp->on_idle_connection_opened(ec, std::move(*conn), std::move(state));
+          }
+        });
+    }
+  }
+
+  void on_idle_connection_opened(error_code ec, basic_connection<Executor>&& conn, std::shared_ptr<warm_up_state> state)
+  {
+    {
+      auto lg = std::lock_guard<std::mutex>{ mtx_ };
+
+      connecting_conns_--;
+      cv_.cancel_one();
+
+      if (ec)
+        detail::increment(metrics_.local().num_connect_failures);
+      else
+        idle_conns_.push_back({ std::move(conn), clock_type::now(), next_expiry() });
+
+      if (state)
+      {
+        if (ec && !state->ec)
+          state->ec = ec;
+        if (--state->pending != 0)
+          state.reset();
+      }
+    }
+
+    // The last connection of a warm-up completes it.
+    if (state)
+      std::move(state->handler)(state->ec);
+  }
+
+  // Must be called with mtx_ held. Lifetimes are shortened by up to a tenth, so connections opened together don't
+  // expire together.
+  clock_type::time_point next_expiry()
+  {
+    if (max_lifetime_ <= clock_type::duration::zero())
+      return clock_type::time_point::max();
+
+    auto jitter = std::uniform_int_distribution<clock_type::rep>{ 0, max_lifetime_.count() / 10 }(rng_);
+    return clock_type::now() + max_lifetime_ - clock_type::duration{ jitter };
+  }
+
+  // Must be called with mtx_ held.
+  void schedule_reaper()
+  {
+    auto period = clock_type::duration::max();
+    for (auto d : { idle_timeout_, max_lifetime_ })
+      if (d > clock_type::duration::zero())
+        period = std::min(period, d);
+
+    if (period == clock_type::duration::max())
+    {
+      reaper_.cancel();
       return;
+    }
 
-    idle_conns_.push(std::move(conn));
+    reaper_.expires_after(std::max<clock_type::duration>(period / 4, std::chrono::seconds{ 1 }));
+    reaper_.async_wait(
+      [wp = this->weak_from_this()](error_code ec)
+      {
+        if (auto sp = wp.lock(); sp && !ec)
+          sp->reap();
+      });
+  }
+
+  // Closes the idle connections that passed max_lifetime, and those unused for idle_timeout as long as min_size
+  // connections stay idle.
+  void reap()
+  {
+    auto expired = std::vector<basic_connection<Executor>>{};
+    auto lg      = std::unique_lock<std::mutex>{ mtx_ };
+    auto now     = clock_type::now();
+
+    for (auto it = idle_conns_.begin(); it != idle_conns_.end();)
+    {
+      auto is_idle_expired = idle_timeout_ > clock_type::duration::zero() && now - it->idle_since >= idle_timeout_ &&
+        idle_conns_.size() > min_size_;
+
+      if (it->expires_at <= now || is_idle_expired)
+      {
+        detail::increment(metrics_.local().num_expired);
+        expired.push_back(std::move(it->conn));
+        it = idle_conns_.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+
+    auto n = reserve_idle_connections();
+    schedule_reaper();
+    lg.unlock();
+    open_idle_connections(n);
   }
 };
 } // namespace detail
 
-template<typename Executor>
-basic_pooled_connection<Executor>::~basic_pooled_connection()
+template<typename Executor, typename PoolImpl>
+basic_pooled_connection<Executor, PoolImpl>::~basic_pooled_connection()
 {
   if (auto sp = conn_pool_.lock())
-    sp->return_connection(std::move(conn_));
+    sp->return_connection(std::move(conn_), expires_at_);
 }
 
 template<typename Executor = asio::any_io_executor>
@@ -187,15 +537,18 @@ class basic_connection_pool
 public:
   using executor_type = Executor;
 
-  basic_connection_pool(Executor exec, std::string conninfo, size_t max_size = 32)
+  // A non-zero min_size starts opening that many idle connections in the background.
+  basic_connection_pool(Executor exec, std::string conninfo, size_t max_size = 32, size_t min_size = 0)
     : impl_{ std::make_shared<impl_type>(std::move(exec), std::move(conninfo), max_size) }
   {
+    impl_->min_size(min_size);
   }
 
   template<typename ExecutionContext>
-  basic_connection_pool(ExecutionContext& context, std::string conninfo, size_t max_size = 32)
+  basic_connection_pool(ExecutionContext& context, std::string conninfo, size_t max_size = 32, size_t min_size = 0)
     : impl_{ std::make_shared<impl_type>(context.get_executor(), std::move(conninfo), max_size) }
   {
+    impl_->min_size(min_size);
   }
 
   template<typename OtherExecutor>
@@ -219,16 +572,105 @@ public:
     impl_->max_size(value);
   }
 
+  size_t min_size() const noexcept
+  {
+    return impl_->min_size();
+  }
+
+  // The low-water mark of idle connections, the pool opens new ones in the background whenever it falls below.
+  void min_size(size_t value)
+  {
+    impl_->min_size(value);
+  }
+
   size_t num_aquired() const noexcept
   {
     return impl_->num_aquired();
   }
 
+  size_t num_idle() const noexcept
+  {
+    return impl_->num_idle();
+  }
+
+  pool_metrics metrics() const noexcept
+  {
+    return impl_->metrics();
+  }
+
+  size_t statement_cache_capacity() const noexcept
+  {
+    return impl_->statement_cache_capacity();
+  }
+
+  std::chrono::steady_clock::duration idle_timeout() const noexcept
+  {
+    return impl_->idle_timeout();
+  }
+
+  // Closes idle connections unused for longer than the given duration, except the min_size most recently used
+  // ones. Zero disables the timeout.
+  void idle_timeout(std::chrono::steady_clock::duration value)
+  {
+    impl_->idle_timeout(value);
+  }
+
+  std::chrono::steady_clock::duration max_lifetime() const noexcept
+  {
+    return impl_->max_lifetime();
+  }
+
+  // Closes connections older than the given duration (less a random jitter of up to 10%) instead of reusing them.
+  // Applies to the connections opened from now on, zero disables it.
+  void max_lifetime(std::chrono::steady_clock::duration value)
+  {
+    impl_->max_lifetime(value);
+  }
+
+  std::chrono::steady_clock::duration connect_attempt_delay() const noexcept
+  {
+    return impl_->connect_attempt_delay();
+  }
+
+  // Opens the connections from now on with async_connect_resolved and the given attempt delay, so the hosts are
+  // resolved without blocking the executor. Zero, the default, opens them with async_connect.
+  void connect_attempt_delay(std::chrono::steady_clock::duration value) noexcept
+  {
+    impl_->connect_attempt_delay(value);
+  }
+
+  // Enables the prepared statement cache on the connections opened from now on. Cached statements live as long as
+  // their connection, so they stay warm across returns to the pool.
+  void statement_cache_capacity(size_t value) noexcept
+  {
+    impl_->statement_cache_capacity(value);
+  }
+
   template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
   auto async_aquire(CompletionToken&& token = CompletionToken{})
   {
     return impl_->async_aquire(std::forward<CompletionToken>(token));
   }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_warm_up(CompletionToken&& token = CompletionToken{})
+  {
+    return impl_->async_warm_up(std::forward<CompletionToken>(token));
+  }
+
+  // The Oids of user-defined types are resolved once for the whole pool, and forgotten when a query fails in a way
+  // that suggests they are stale.
+  const std::shared_ptr<oid_cache>& shared_oid_cache() const noexcept
+  {
+    return impl_->shared_oid_cache();
+  }
+
+  // Resolves the user-defined types in a single query on one of the connections, so no query pays for it later.
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_register_types(CompletionToken&& token = CompletionToken{})
+  {
+    return impl_->template async_register_types<Ts...>(std::forward<CompletionToken>(token));
+  }
 };
 
 using connection_pool   = basic_connection_pool<>;
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <psql/connection.hpp>
+#include <psql/detail/escape_identifier.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+namespace psql
+{
+struct cursor_options
+{
+  // The size of the batches is adapted to the width of the rows, so each batch takes about this much memory.
+  size_t target_batch_bytes = 1024 * 1024;
+  size_t min_batch_rows     = 16;
+  size_t max_batch_rows     = 65536;
+  // Keeps the cursor open after the transaction that declared it commits, it must be closed explicitly then.
+  bool with_hold = false;
+};
+
+namespace detail
+{
+template<typename Executor>
+class basic_cursor_impl : public std::enable_shared_from_this<basic_cursor_impl<Executor>>
+{
+  using error_code      = boost::system::error_code;
+  using connection_type = basic_connection<Executor>;
+
+  // The width assumed for fields of variable-length types until a batch has been received, and the memory libpq
+  // takes for each field besides its value.
+  static constexpr size_t variable_field_width = 32;
+  static constexpr size_t field_overhead       = sizeof(char*) + sizeof(int);
+
+  connection_type& conn_;
+  std::string name_;
+  std::string escaped_name_;
+  cursor_options options_;
+  size_t batch_size_{};
+  size_t num_requested_{};
+  result fetched_;
+  error_code fetched_ec_;
+  asio::any_completion_handler<void(error_code, result)> handler_;
+  bool is_fetching_{};
+  bool is_fetched_{};
+  bool is_exhausted_{};
+
+public:
+  basic_cursor_impl(connection_type& conn, std::string name, cursor_options options)
+    : conn_{ conn }
+    , name_{ std::move(name) }
+    , escaped_name_{ escape_identifier(conn_.native_handle(), name_) }
+    , options_{ options }
+    , batch_size_{ options.min_batch_rows }
+  {
+  }
+
+  connection_type& connection() noexcept
+  {
+    return conn_;
+  }
+
+  size_t batch_size() const noexcept
+  {
+    return batch_size_;
+  }
+
+  bool is_exhausted() const noexcept
+  {
+    return is_exhausted_ && !is_fetching_ && !is_fetched_;
+  }
+
+  // Declares the cursor, sizes the first batch from the description of its portal and requests the first batch.
+  template<typename... Ts, typename CompletionToken>
+  auto async_declare(std::string query, params<Ts...> params, CompletionToken&& token)
+  {
+    return asio::async_compose<CompletionToken, void(error_code)>(
+      [this,
+       sp     = this->shared_from_this(),
+       coro   = asio::coroutine{},
+       query  = declare_query(query),
+       params = std::move(params)](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        if (ec)
+          return self.complete(ec);
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          BOOST_ASIO_CORO_YIELD conn_.async_query(std::move(query), std::move(params), std::move(self));
+          BOOST_ASIO_CORO_YIELD conn_.async_describe_portal(name_, std::move(self));
+
+          batch_size_ = clamp_batch_size(options_.target_batch_bytes / estimate_row_width(result));
+          fetch_next();
+          return self.complete({});
+        }
+      },
+      token,
+      conn_);
+  }
+
+  // Completes with the batch that has been prefetched, or waits for it, and requests the next one before that.
+  void async_fetch_erased(asio::any_completion_handler<void(error_code, result)> handler)
+  {
+    handler_ = std::move(handler);
+
+    if (is_fetched_)
+      return deliver();
+
+    if (!is_fetching_)
+      return asio::post(asio::append(std::move(handler_), error_code{}, result{}));
+  }
+
+  template<typename CompletionToken>
+  auto async_close(CompletionToken&& token)
+  {
+    return asio::async_compose<CompletionToken, void(error_code)>(
+      [this, sp = this->shared_from_this(), coro = asio::coroutine{}](
+        auto& self, error_code ec = {}, result = {}) mutable
+      {
+        if (ec)
+          return self.complete(ec);
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          is_exhausted_ = true;
+
+          // The prefetched batch is discarded, CLOSE can't be sent while a FETCH is in flight.
+          if (is_fetching_ || is_fetched_)
+          {
+            BOOST_ASIO_CORO_YIELD async_fetch_erased(std::move(self));
+          }
+
+          BOOST_ASIO_CORO_YIELD conn_.async_query("CLOSE " + escaped_name_, std::move(self));
+          return self.complete({});
+        }
+      },
+      token,
+      conn_);
+  }
+
+private:
+  std::string declare_query(const std::string& query) const
+  {
+    return "DECLARE " + escaped_name_ + " NO SCROLL CURSOR " + (options_.with_hold ? "WITH HOLD " : "") + "FOR " +
+           query;
+  }
+
+  void fetch_next()
+  {
+    num_requested_ = batch_size_;
+    is_fetching_   = true;
+    conn_.async_query(
+      "FETCH FORWARD " + std::to_string(num_requested_) + " FROM " + escaped_name_,
+      [sp = this->shared_from_this()](error_code ec, result result) { sp->on_fetched(ec, std::move(result)); });
+  }
+
+  void on_fetched(error_code ec, result result)
+  {
+    is_fetching_ = false;
+    is_fetched_  = true;
+    fetched_ec_  = ec;
+
+    // A short batch means the end of the cursor has been reached.
+    if (ec || result.size() < num_requested_)
+      is_exhausted_ = true;
+    else if (!result.empty())
+      batch_size_ = clamp_batch_size(options_.target_batch_bytes * result.size() / memory_size(result));
+
+    fetched_ = std::move(result);
+
+    if (handler_)
+      deliver();
+  }
+
+  void deliver()
+  {
+    is_fetched_  = false;
+    auto ec      = std::exchange(fetched_ec_, {});
+    auto fetched = std::move(fetched_);
+
+    // The next batch is requested before the current one is handed over, so it's on its way while being processed.
+    if (!is_exhausted_)
+      fetch_next();
+
+    asio::post(asio::append(std::move(handler_), ec, std::move(fetched)));
+  }
+
+  size_t clamp_batch_size(size_t rows) const noexcept
+  {
+    return std::clamp(rows, options_.min_batch_rows, std::max(options_.min_batch_rows, options_.max_batch_rows));
+  }
+
+  static size_t memory_size(const result& result) noexcept
+  {
+    return std::max<size_t>(PQresultMemorySize(result.native_handle()), 1);
+  }
+
+  static size_t estimate_row_width(const result& description) noexcept
+  {
+    auto width = sizeof(void*);
+    for (int i = 0; i < PQnfields(description.native_handle()); i++)
+    {
+      const auto size = PQfsize(description.native_handle(), i);
+      width += field_overhead + (size > 0 ? static_cast<size_t>(size) : variable_field_width);
+    }
+    return width;
+  }
+};
+} // namespace detail
+
+// Reads the rows of a query in batches through a server-side cursor. The next batch is fetched while the current
+// one is being processed, and batches are sized after the width of the rows. Unless auto-pipelining is enabled on
+// the connection, no other operation can be started on it until the cursor is exhausted or closed. A cursor declared
+// without `with_hold` must be used within a transaction block, and is closed when the transaction ends.
+template<typename Executor = asio::any_io_executor>
+class basic_cursor
+{
+  using error_code = boost::system::error_code;
+  using impl_type  = detail::basic_cursor_impl<Executor>;
+
+  std::shared_ptr<impl_type> impl_;
+
+public:
+  using executor_type = Executor;
+
+  basic_cursor(basic_connection<Executor>& conn, std::string name, cursor_options options = {})
+    : impl_{ std::make_shared<impl_type>(conn, std::move(name), options) }
+  {
+  }
+
+  executor_type get_executor() const noexcept
+  {
+    return impl_->connection().get_executor();
+  }
+
+  // The number of rows requested by the next FETCH.
+  size_t batch_size() const noexcept
+  {
+    return impl_->batch_size();
+  }
+
+  // Whether all the batches have been received, the last one might be empty.
+  bool is_exhausted() const noexcept
+  {
+    return impl_->is_exhausted();
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_declare(std::string query, CompletionToken&& token = CompletionToken{})
+  {
+    return async_declare(std::move(query), {}, std::forward<CompletionToken>(token));
+  }
+
+  template<typename... Ts, typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_declare(std::string query, params<Ts...> params, CompletionToken&& token = CompletionToken{})
+  {
+    return impl_->async_declare(std::move(query), std::move(params), std::forward<CompletionToken>(token));
+  }
+
+  // Completes with the next batch of rows, or with an empty result once the cursor is exhausted.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_fetch(CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_initiate<CompletionToken, void(error_code, result)>(
+      [](auto handler, std::shared_ptr<impl_type> impl) { impl->async_fetch_erased(std::move(handler)); },
+      token,
+      impl_);
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_close(CompletionToken&& token = CompletionToken{})
+  {
+    return impl_->async_close(std::forward<CompletionToken>(token));
+  }
+};
+
+using cursor = basic_cursor<>;
+} // namespace psql
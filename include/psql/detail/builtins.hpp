@@ -1,11 +1,14 @@
 #pragma once
 
 #include <psql/detail/oid_pair.hpp>
+#include <psql/types.hpp>
 
 #include <chrono>
 #include <cstdint>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace psql
 {
@@ -92,6 +95,54 @@ struct builtin<const char*>
   static constexpr oid_pair oids{ 25, 1009 };
 };
 
+template<>
+struct builtin<std::vector<std::byte>>
+{
+  static constexpr oid_pair oids{ 17, 1001 };
+};
+
+template<>
+struct builtin<std::span<const std::byte>>
+{
+  static constexpr oid_pair oids{ 17, 1001 };
+};
+
+template<>
+struct builtin<uuid>
+{
+  static constexpr oid_pair oids{ 2950, 2951 };
+};
+
+template<>
+struct builtin<numeric>
+{
+  static constexpr oid_pair oids{ 1700, 1231 };
+};
+
+template<>
+struct builtin<jsonb_view>
+{
+  static constexpr oid_pair oids{ 3802, 3807 };
+};
+
+template<>
+struct builtin<std::chrono::sys_days>
+{
+  static constexpr oid_pair oids{ 1082, 1182 };
+};
+
+template<>
+struct builtin<interval>
+{
+  static constexpr oid_pair oids{ 1186, 1187 };
+};
+
+template<>
+struct builtin<timestamptz>
+{
+  static constexpr oid_pair oids{ 1184, 1185 };
+};
+
 template<typename... Ts>
 struct builtin<std::tuple<Ts...>>
 {
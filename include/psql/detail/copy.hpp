@@ -0,0 +1,172 @@
+#pragma once
+
+#include <psql/detail/deserialization.hpp>
+#include <psql/detail/extract_new_udts.hpp>
+#include <psql/detail/serialization.hpp>
+
+#include <boost/pfr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+
+namespace psql
+{
+namespace detail
+{
+// The size of the chunks passed to PQputCopyData, rows are accumulated in the connection buffer up to this size.
+constexpr std::size_t copy_chunk_size = 256 * 1024;
+
+constexpr std::string_view copy_signature{ "PGCOPY\n\377\r\n\0", 11 };
+
+template<typename T>
+struct copy_row_tuple
+{
+  using type = decltype(boost::pfr::structure_to_tuple(std::declval<T>()));
+};
+
+template<typename T>
+  requires(is_tuple_v<T>)
+struct copy_row_tuple<T>
+{
+  using type = T;
+};
+
+template<typename T>
+using copy_row_tuple_t = typename copy_row_tuple<T>::type;
+
+template<typename T>
+void extract_new_udts_of_copy_row(std::vector<udt_pair>& new_udts, const oid_map& omp)
+{
+  extract_new_udts<copy_row_tuple_t<T>>(new_udts, omp);
+}
+
+inline void serialize_copy_header(const oid_map& omp, std::string& buffer)
+{
+  buffer.append(copy_signature);
+  serialize<int32_t>(omp, buffer, 0); // flags field
+  serialize<int32_t>(omp, buffer, 0); // header extension area length
+}
+
+inline void serialize_copy_trailer(const oid_map& omp, std::string& buffer)
+{
+  serialize<int16_t>(omp, buffer, -1);
+}
+
+template<typename T>
+void serialize_copy_field(const oid_map& omp, std::string& buffer, const T& value)
+{
+  serialize_with_length(omp, buffer, value);
+}
+
+template<typename T>
+void serialize_copy_row(const oid_map& omp, std::string& buffer, const T& row)
+{
+  if constexpr (is_tuple_v<T>)
+  {
+    serialize<int16_t>(omp, buffer, std::tuple_size_v<T>);
+    std::apply([&](const auto&... fs) { (serialize_copy_field(omp, buffer, fs), ...); }, row);
+  }
+  else
+  {
+    serialize<int16_t>(omp, buffer, boost::pfr::tuple_size_v<T>);
+    boost::pfr::for_each_field(row, [&](const auto& f) { serialize_copy_field(omp, buffer, f); });
+  }
+}
+
+// Consumes the header at the beginning of the COPY data, returns false if the signature doesn't match.
+inline bool deserialize_copy_header(std::span<const char>& buffer)
+{
+  constexpr auto header_size = copy_signature.size() + 8;
+
+  if (buffer.size() < header_size || !std::equal(copy_signature.begin(), copy_signature.end(), buffer.begin()))
+    return false;
+
+  int32_t extension_size = {};
+  deserialize<int32_t>(buffer.subspan(copy_signature.size() + 4), extension_size);
+
+  if (extension_size < 0 || buffer.size() - header_size < static_cast<size_t>(extension_size))
+    return false;
+
+  buffer = buffer.subspan(header_size + extension_size); // consumes buffer
+  return true;
+}
+
+inline bool is_copy_trailer(std::span<const char> buffer)
+{
+  int16_t count = {};
+  if (buffer.size() >= 2)
+    deserialize<int16_t>(buffer, count);
+  return count == -1;
+}
+
+// The size of the binary representation of fixed-width types, 0 for the others. Binary COPY data carries no type
+// Oids, so the size of a field is the only check that its column has the type of the member.
+template<typename T>
+constexpr std::size_t copy_field_width_v = std::is_arithmetic_v<T> ? sizeof(T) : 0;
+
+template<>
+constexpr std::size_t copy_field_width_v<std::chrono::system_clock::time_point> = 8;
+
+template<>
+constexpr std::size_t copy_field_width_v<std::chrono::sys_days> = 4;
+
+template<>
+constexpr std::size_t copy_field_width_v<timestamptz> = 8;
+
+template<>
+constexpr std::size_t copy_field_width_v<interval> = 16;
+
+template<>
+constexpr std::size_t copy_field_width_v<uuid> = 16;
+
+template<typename T>
+bool deserialize_copy_field(std::span<const char>& buffer, T& value)
+{
+  int32_t size = {};
+  if (buffer.size() < 4)
+    return false;
+  deserialize<int32_t>(buffer, size);
+
+  // NULL fields (-1) have no representation in the row types.
+  if (size < 0 || buffer.size() - 4 < static_cast<size_t>(size))
+    return false;
+
+  if constexpr (copy_field_width_v<T> != 0)
+  {
+    if (static_cast<size_t>(size) != copy_field_width_v<T>)
+      return false;
+  }
+
+  deserialize(buffer.subspan(4, size), value);
+  buffer = buffer.subspan(4 + size); // consumes buffer
+  return true;
+}
+
+// Deserializes a tuple of the COPY data, returns false if it doesn't match the row type.
+template<typename T>
+bool deserialize_copy_row(std::span<const char> buffer, T& row)
+{
+  int16_t count = {};
+  if (buffer.size() < 2)
+    return false;
+  deserialize<int16_t>(buffer, count);
+  buffer = buffer.subspan(2);
+
+  if constexpr (is_tuple_v<T>)
+  {
+    if (count != std::tuple_size_v<T>)
+      return false;
+    return std::apply([&](auto&... fs) { return (deserialize_copy_field(buffer, fs) && ...); }, row);
+  }
+  else
+  {
+    if (count != boost::pfr::tuple_size_v<T>)
+      return false;
+    auto is_valid = true;
+    boost::pfr::for_each_field(row, [&](auto& f) { is_valid = is_valid && deserialize_copy_field(buffer, f); });
+    return is_valid;
+  }
+}
+} // namespace detail
+} // namespace psql
@@ -6,6 +6,7 @@
 #include <boost/endian.hpp>
 #include <boost/pfr.hpp>
 
+#include <cstring>
 #include <span>
 
 namespace psql
@@ -21,6 +22,16 @@ void deserialize(std::span<const char> buffer, T& v)
   deserialize_impl<std::decay_t<T>>::apply(buffer, v);
 }
 
+// Skips the Oid and member count checks of composite and array values, which must have been verified beforehand.
+template<typename T>
+void deserialize_unchecked(std::span<const char> buffer, T& v)
+{
+  if constexpr (is_composite_v<std::decay_t<T>> || is_array_v<std::decay_t<T>>)
+    deserialize_impl<std::decay_t<T>>::apply_unchecked(buffer, v);
+  else
+    deserialize_impl<std::decay_t<T>>::apply(buffer, v);
+}
+
 template<typename T>
   requires(std::is_integral_v<T> || std::is_floating_point_v<T> || std::is_same_v<T, std::byte>)
 struct deserialize_impl<T>
@@ -61,6 +72,106 @@ struct deserialize_impl<std::string>
   }
 };
 
+template<>
+struct deserialize_impl<std::vector<std::byte>>
+{
+  static void apply(std::span<const char> buffer, std::vector<std::byte>& value)
+  {
+    const auto* p = reinterpret_cast<const std::byte*>(buffer.data());
+    value.assign(p, p + buffer.size());
+  }
+};
+
+template<>
+struct deserialize_impl<std::span<const std::byte>>
+{
+  static void apply(std::span<const char> buffer, std::span<const std::byte>& value)
+  {
+    value = std::as_bytes(buffer);
+  }
+};
+
+template<>
+struct deserialize_impl<std::chrono::sys_days>
+{
+  static void apply(std::span<const char> buffer, std::chrono::sys_days& value)
+  {
+    int32_t int_value{};
+    deserialize(buffer, int_value);
+    value = std::chrono::sys_days{ std::chrono::days{ int64_t{ int_value } + 10957 } };
+  }
+};
+
+template<>
+struct deserialize_impl<timestamptz>
+{
+  static void apply(std::span<const char> buffer, timestamptz& value)
+  {
+    deserialize(buffer, value.time);
+  }
+};
+
+template<>
+struct deserialize_impl<interval>
+{
+  static void apply(std::span<const char> buffer, interval& value)
+  {
+    int64_t time{};
+    deserialize(buffer, time);
+    value.time = std::chrono::microseconds{ time };
+    deserialize(buffer.subspan(8), value.days);
+    deserialize(buffer.subspan(12), value.months);
+  }
+};
+
+template<>
+struct deserialize_impl<uuid>
+{
+  static void apply(std::span<const char> buffer, uuid& value)
+  {
+    if (buffer.size() != value.bytes.size())
+      throw std::runtime_error{ "Unexpected length of uuid value" };
+
+    std::memcpy(value.bytes.data(), buffer.data(), value.bytes.size());
+  }
+};
+
+template<>
+struct deserialize_impl<numeric>
+{
+  static void apply(std::span<const char> buffer, numeric& value)
+  {
+    if (buffer.size() < 8)
+      throw std::runtime_error{ "Unexpected length of numeric value" };
+
+    int16_t num_digits{};
+    deserialize(buffer, num_digits);
+
+    if (num_digits < 0 || buffer.size() < 8 + 2 * static_cast<size_t>(num_digits))
+      throw std::runtime_error{ "Unexpected number of digits in numeric value" };
+
+    deserialize(buffer.subspan(2), value.weight);
+    deserialize(buffer.subspan(4), value.sign);
+    deserialize(buffer.subspan(6), value.dscale);
+
+    value.digits.resize(num_digits);
+    for (int16_t i = 0; i < num_digits; i++)
+      deserialize(buffer.subspan(8 + 2 * i), value.digits[i]);
+  }
+};
+
+template<>
+struct deserialize_impl<jsonb_view>
+{
+  static void apply(std::span<const char> buffer, jsonb_view& value)
+  {
+    if (buffer.empty() || buffer.front() != 1)
+      throw std::runtime_error{ "Unsupported version of jsonb format" };
+
+    value.json = { buffer.data() + 1, buffer.size() - 1 };
+  }
+};
+
 inline void deserialize_and_verify_oid(std::span<const char> buffer, uint32_t expected_oid)
 {
   uint32_t oid = {};
@@ -75,15 +186,19 @@ template<typename T>
   requires(is_composite_v<T>)
 struct deserialize_impl<T>
 {
-  template<typename U>
+  template<bool Checked, typename U>
   static void deserialize_member(std::span<const char>& buffer, U& value)
   {
-    deserialize_and_verify_oid(buffer, oid_of<U>());
+    if constexpr (Checked)
+      deserialize_and_verify_oid(buffer, oid_of<U>());
 
     int32_t member_size = {};
     deserialize<int32_t>(buffer.subspan(4), member_size);
 
-    deserialize(buffer.subspan(8, member_size), value);
+    if constexpr (Checked)
+      deserialize(buffer.subspan(8, member_size), value);
+    else
+      deserialize_unchecked(buffer.subspan(8, member_size), value);
 
     buffer = buffer.subspan(8 + member_size); // consumes buffer
   }
@@ -103,7 +218,7 @@ struct deserialize_impl<T>
   {
     verify_member_counts(buffer, boost::pfr::tuple_size_v<T>);
     buffer = buffer.subspan(4);
-    boost::pfr::for_each_field(value, [&](auto& f) { deserialize_member(buffer, f); });
+    boost::pfr::for_each_field(value, [&](auto& f) { deserialize_member<true>(buffer, f); });
   }
 
   static void apply(std::span<const char> buffer, T& value)
@@ -111,7 +226,21 @@ struct deserialize_impl<T>
   {
     verify_member_counts(buffer, std::tuple_size_v<T>);
     buffer = buffer.subspan(4);
-    std::apply([&](auto&&... ms) { (deserialize_member(buffer, ms), ...); }, value);
+    std::apply([&](auto&&... ms) { (deserialize_member<true>(buffer, ms), ...); }, value);
+  }
+
+  static void apply_unchecked(std::span<const char> buffer, T& value)
+    requires(is_user_defined_v<T>)
+  {
+    buffer = buffer.subspan(4);
+    boost::pfr::for_each_field(value, [&](auto& f) { deserialize_member<false>(buffer, f); });
+  }
+
+  static void apply_unchecked(std::span<const char> buffer, T& value)
+    requires(is_tuple_v<T>)
+  {
+    buffer = buffer.subspan(4);
+    std::apply([&](auto&&... ms) { (deserialize_member<false>(buffer, ms), ...); }, value);
   }
 };
 
@@ -122,6 +251,19 @@ struct deserialize_impl<T>
   using value_type = std::decay_t<typename T::value_type>;
 
   static void apply(std::span<const char> buffer, T& array)
+  {
+    decode<true>(buffer, array);
+  }
+
+  // The dimensions are still checked, they are a property of each value rather than of the element type.
+  static void apply_unchecked(std::span<const char> buffer, T& array)
+  {
+    decode<false>(buffer, array);
+  }
+
+private:
+  template<bool Checked>
+  static void decode(std::span<const char> buffer, T& array)
   {
     int32_t dimensions_count = {};
     deserialize<int32_t>(buffer.subspan(0), dimensions_count);
@@ -129,7 +271,8 @@ struct deserialize_impl<T>
     if (dimensions_count != 1)
       throw std::runtime_error{ "Unexpected multidimensional array" };
 
-    deserialize_and_verify_oid(buffer.subspan(8), oid_of<value_type>());
+    if constexpr (Checked)
+      deserialize_and_verify_oid(buffer.subspan(8), oid_of<value_type>());
 
     int32_t size = {};
     deserialize<int32_t>(buffer.subspan(12), size);
@@ -141,7 +284,10 @@ struct deserialize_impl<T>
     {
       int32_t value_size = {};
       deserialize<int32_t>(buffer, value_size);
-      deserialize(buffer.subspan(4, value_size), value);
+      if constexpr (Checked)
+        deserialize(buffer.subspan(4, value_size), value);
+      else
+        deserialize_unchecked(buffer.subspan(4, value_size), value);
       buffer = buffer.subspan(4 + value_size); // consumes buffer
     }
   }
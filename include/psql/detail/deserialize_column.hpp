@@ -0,0 +1,102 @@
+#pragma once
+
+#include <psql/detail/deserialization.hpp>
+
+#include <libpq-fe.h>
+
+#include <bit>
+#include <cstring>
+#include <vector>
+
+namespace psql
+{
+namespace detail
+{
+template<size_t N>
+struct unsigned_of_size;
+
+template<>
+struct unsigned_of_size<1>
+{
+  using type = uint8_t;
+};
+
+template<>
+struct unsigned_of_size<2>
+{
+  using type = uint16_t;
+};
+
+template<>
+struct unsigned_of_size<4>
+{
+  using type = uint32_t;
+};
+
+template<>
+struct unsigned_of_size<8>
+{
+  using type = uint64_t;
+};
+
+inline void verify_column(const PGresult* pg_result, int col, uint32_t expected_oid)
+{
+  if (col >= PQnfields(pg_result))
+    throw std::out_of_range{ std::string{ "No field at index " } + std::to_string(col) + " exists" };
+
+  const auto oid = PQftype(pg_result, col);
+  if (expected_oid != 0 && expected_oid != oid)
+    throw std::runtime_error{ "Mismatched Object Identifiers (OIDs) in received and expected types. Found " +
+                              std::to_string(oid) + " instead of " + std::to_string(expected_oid) };
+}
+
+[[noreturn]] inline void throw_unexpected_length(int row, int col, size_t expected_size)
+{
+  throw std::runtime_error{ "Unexpected value length at row " + std::to_string(row) + " of field " +
+                            std::to_string(col) + ", expected " + std::to_string(expected_size) + " bytes" };
+}
+
+template<typename T>
+void deserialize_column(const PGresult* pg_result, int col, std::vector<T>& column)
+{
+  verify_column(pg_result, col, oid_of<T>());
+
+  const auto rows = PQntuples(pg_result);
+  column.resize(rows);
+
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    // std::vector<bool> has no addressable elements.
+    for (int i = 0; i < rows; i++)
+    {
+      if (PQgetlength(pg_result, i, col) != 1)
+        throw_unexpected_length(i, col, 1);
+      column[i] = *PQgetvalue(pg_result, i, col) != 0;
+    }
+  }
+  else if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>)
+  {
+    // Gathers the raw big-endian values first and swaps them in a separate pass over contiguous memory, which the
+    // compiler can vectorize. Null values have a length of zero and are rejected by the length check.
+    for (int i = 0; i < rows; i++)
+    {
+      if (PQgetlength(pg_result, i, col) != sizeof(T))
+        throw_unexpected_length(i, col, sizeof(T));
+      std::memcpy(&column[i], PQgetvalue(pg_result, i, col), sizeof(T));
+    }
+
+    if constexpr (sizeof(T) != 1 && std::endian::native == std::endian::little)
+    {
+      using unsigned_type = typename unsigned_of_size<sizeof(T)>::type;
+      for (auto& value : column)
+        value = std::bit_cast<T>(boost::endian::endian_reverse(std::bit_cast<unsigned_type>(value)));
+    }
+  }
+  else
+  {
+    for (int i = 0; i < rows; i++)
+      deserialize({ PQgetvalue(pg_result, i, col), static_cast<size_t>(PQgetlength(pg_result, i, col)) }, column[i]);
+  }
+}
+} // namespace detail
+} // namespace psql
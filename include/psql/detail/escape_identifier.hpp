@@ -0,0 +1,24 @@
+#pragma once
+
+#include <libpq-fe.h>
+
+#include <string>
+#include <string_view>
+
+namespace psql
+{
+namespace detail
+{
+// Quotes an identifier so it's matched exactly, returns an empty string if libpq fails to escape it.
+inline std::string escape_identifier(PGconn* pgconn, std::string_view identifier)
+{
+  auto escaped = std::string{};
+  if (auto* p = PQescapeIdentifier(pgconn, identifier.data(), identifier.size()))
+  {
+    escaped = p;
+    PQfreemem(p);
+  }
+  return escaped;
+}
+} // namespace detail
+} // namespace psql
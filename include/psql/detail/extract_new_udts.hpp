@@ -46,8 +46,8 @@ struct extract_new_udts_impl<T>
   static constexpr void apply(std::vector<udt_pair>& new_udts, const detail::oid_map& omp)
     requires(is_user_defined_v<T>)
   {
-    if (!omp.contains(typeid(T)))
-      new_udts.push_back({ user_defined<T>::name, typeid(T) });
+    if (!omp.contains<T>())
+      new_udts.push_back({ user_defined<T>::name, udt_slot<T>() });
 
     [&]<typename... Ts>(type_tag<std::tuple<Ts...>>) {
       (extract_new_udts<Ts>(new_udts, omp), ...);
@@ -60,5 +60,55 @@ struct extract_new_udts_impl<T>
     [&]<typename... Ts>(type_tag<std::tuple<Ts...>>) { (extract_new_udts<Ts>(new_udts, omp), ...); }(type_tag<T>{});
   }
 };
+
+// Signatures whose types have all been resolved are remembered, so later calls skip walking the types.
+template<typename... Ts>
+void extract_new_udts_of_params(std::vector<udt_pair>& new_udts, detail::oid_map& omp)
+{
+  const auto slot = signature_slot<Ts...>();
+  if (omp.is_resolved(slot))
+    return;
+
+  const auto size = new_udts.size();
+  (extract_new_udts<Ts>(new_udts, omp), ...);
+
+  if (new_udts.size() == size)
+    omp.mark_resolved(slot);
+}
+
+struct nested_udts_tag;
+
+// The Oid of a parameter of a prepared statement is known already, only the ones written into its value are needed,
+// such as the fields of a composite or the element type of an array.
+template<typename T>
+void extract_nested_udts(std::vector<udt_pair>& new_udts, const detail::oid_map& omp)
+{
+  using U = std::decay_t<T>;
+
+  if constexpr (is_user_defined_v<U> && is_composite_v<U>)
+  {
+    [&]<typename... Ms>(std::tuple<Ms...>*) {
+      (extract_new_udts<Ms>(new_udts, omp), ...);
+    }(static_cast<decltype(boost::pfr::structure_to_tuple(std::declval<U>()))*>(nullptr));
+  }
+  else if constexpr (!is_user_defined_v<U>)
+  {
+    extract_new_udts<U>(new_udts, omp);
+  }
+}
+
+template<typename... Ts>
+void extract_nested_udts_of_params(std::vector<udt_pair>& new_udts, detail::oid_map& omp)
+{
+  const auto slot = signature_slot<nested_udts_tag, Ts...>();
+  if (omp.is_resolved(slot))
+    return;
+
+  const auto size = new_udts.size();
+  (extract_nested_udts<Ts>(new_udts, omp), ...);
+
+  if (new_udts.size() == size)
+    omp.mark_resolved(slot);
+}
 } // namespace detail
 } // namespace psql
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace psql
+{
+namespace detail
+{
+// Recycles the memory of the operation states and handlers of a connection. Freed blocks are kept in free lists of
+// power-of-two size classes, so once the lists are warmed up the operations of a connection don't allocate anymore.
+class handler_memory
+{
+  struct block
+  {
+    block* next;
+  };
+
+  static constexpr std::size_t min_block_size  = 64;
+  static constexpr std::size_t num_size_classes = 6; // up to 2 KiB, larger blocks always come from the heap
+  static constexpr std::size_t max_free_blocks  = 64; // per size class
+
+  std::mutex mtx_;
+  std::array<block*, num_size_classes> free_lists_{};
+  std::array<std::size_t, num_size_classes> num_free_{};
+  std::atomic<std::uint64_t> num_allocations_{};
+
+public:
+  handler_memory() = default;
+
+  handler_memory(const handler_memory&)            = delete;
+  handler_memory& operator=(const handler_memory&) = delete;
+
+  ~handler_memory()
+  {
+    for (auto* head : free_lists_)
+    {
+      while (head)
+        ::operator delete(std::exchange(head, head->next));
+    }
+  }
+
+  // The number of blocks that had to be allocated on the heap.
+  std::uint64_t num_allocations() const noexcept
+  {
+    return num_allocations_.load(std::memory_order_relaxed);
+  }
+
+  void* allocate(std::size_t size, std::size_t alignment)
+  {
+    const auto size_class = size_class_of(size, alignment);
+
+    if (size_class < num_size_classes)
+    {
+      auto lg = std::lock_guard<std::mutex>{ mtx_ };
+      if (auto* b = free_lists_[size_class])
+      {
+        free_lists_[size_class] = b->next;
+        num_free_[size_class]--;
+        return b;
+      }
+    }
+
+    num_allocations_.fetch_add(1, std::memory_order_relaxed);
+
+    if (size_class < num_size_classes)
+      return ::operator new(min_block_size << size_class);
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      return ::operator new(size, std::align_val_t{ alignment });
+    return ::operator new(size);
+  }
+
+  void deallocate(void* p, std::size_t size, std::size_t alignment) noexcept
+  {
+    const auto size_class = size_class_of(size, alignment);
+
+    if (size_class < num_size_classes)
+    {
+      auto lg = std::lock_guard<std::mutex>{ mtx_ };
+      if (num_free_[size_class] < max_free_blocks)
+      {
+        free_lists_[size_class] = new (p) block{ free_lists_[size_class] };
+        num_free_[size_class]++;
+        return;
+      }
+    }
+
+    if (size_class >= num_size_classes && alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      return ::operator delete(p, std::align_val_t{ alignment });
+    ::operator delete(p);
+  }
+
+private:
+  static std::size_t size_class_of(std::size_t size, std::size_t alignment) noexcept
+  {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      return num_size_classes;
+
+    auto size_class = std::size_t{};
+    while (size_class < num_size_classes && (min_block_size << size_class) < size)
+      size_class++;
+    return size_class;
+  }
+};
+
+// An allocator backed by the recycled memory of a connection. The memory is shared with the allocator, so handlers
+// that are destroyed after their connection can still free their storage.
+template<typename T>
+class handler_allocator
+{
+  template<typename>
+  friend class handler_allocator;
+
+  std::shared_ptr<handler_memory> memory_;
+
+public:
+  using value_type = T;
+
+  explicit handler_allocator(std::shared_ptr<handler_memory> memory) noexcept
+    : memory_{ std::move(memory) }
+  {
+  }
+
+  template<typename U>
+  handler_allocator(const handler_allocator<U>& other) noexcept
+    : memory_{ other.memory_ }
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    return static_cast<T*>(memory_->allocate(sizeof(T) * n, alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    memory_->deallocate(p, sizeof(T) * n, alignof(T));
+  }
+
+  template<typename U>
+  bool operator==(const handler_allocator<U>& other) const noexcept
+  {
+    return memory_ == other.memory_;
+  }
+};
+} // namespace detail
+} // namespace psql
@@ -2,13 +2,110 @@
 
 #include <psql/detail/oid_pair.hpp>
 
-#include <map>
-#include <typeindex>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
 
 namespace psql
 {
 namespace detail
 {
-using oid_map = std::map<std::type_index, oid_pair>;
+struct udt_slot_tag;
+struct signature_slot_tag;
+
+template<typename Tag>
+size_t next_slot() noexcept
+{
+  static auto counter = std::atomic<size_t>{};
+  return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+// A dense index per type, assigned on first use and shared by all the oid_maps.
+template<typename T>
+size_t udt_slot() noexcept
+{
+  static const auto slot = next_slot<udt_slot_tag>();
+  return slot;
+}
+
+template<typename... Ts>
+size_t signature_slot() noexcept
+{
+  static const auto slot = next_slot<signature_slot_tag>();
+  return slot;
+}
+
+// Oids of user-defined types indexed by their udt_slot, along with the parameter signatures whose types are all
+// known already.
+class oid_map
+{
+  std::vector<oid_pair> oids_; // zeros for unknown types
+  std::vector<bool> resolved_signatures_;
+
+public:
+  template<typename T>
+  const oid_pair& at() const
+  {
+    auto slot = udt_slot<T>();
+    if (!contains(slot))
+      throw std::out_of_range{ "Oid of the user-defined type is unknown" };
+    return oids_[slot];
+  }
+
+  template<typename T>
+  bool contains() const noexcept
+  {
+    return contains(udt_slot<T>());
+  }
+
+  // Whether no Oid of a user-defined type is known.
+  bool empty() const noexcept
+  {
+    return oids_.empty();
+  }
+
+  bool contains(size_t slot) const noexcept
+  {
+    return slot < oids_.size() && oids_[slot].single != 0;
+  }
+
+  // Whether the Oid is the one of a known user-defined type, or of its array type.
+  bool contains_oid(uint32_t oid) const noexcept
+  {
+    return oid != 0 && std::ranges::any_of(oids_, [&](const oid_pair& p) { return p.single == oid || p.array == oid; });
+  }
+
+  const oid_pair* find(size_t slot) const noexcept
+  {
+    return contains(slot) ? &oids_[slot] : nullptr;
+  }
+
+  void emplace(size_t slot, oid_pair oids)
+  {
+    if (slot >= oids_.size())
+      oids_.resize(slot + 1);
+    oids_[slot] = oids;
+  }
+
+  bool is_resolved(size_t signature_slot) const noexcept
+  {
+    return signature_slot < resolved_signatures_.size() && resolved_signatures_[signature_slot];
+  }
+
+  void mark_resolved(size_t signature_slot)
+  {
+    if (signature_slot >= resolved_signatures_.size())
+      resolved_signatures_.resize(signature_slot + 1);
+    resolved_signatures_[signature_slot] = true;
+  }
+
+  void clear() noexcept
+  {
+    oids_.clear();
+    resolved_signatures_.clear();
+  }
+};
 } // namespace detail
 } // namespace psql
@@ -44,7 +44,7 @@ struct oid_of_impl<T>
   static constexpr uint32_t apply(const oid_map& omp)
     requires(is_user_defined_v<value_type>)
   {
-    return omp.at(typeid(value_type)).array;
+    return omp.at<value_type>().array;
   }
 
   static constexpr uint32_t apply()
@@ -73,7 +73,7 @@ struct oid_of_impl<T>
   static constexpr uint32_t apply(const oid_map& omp)
     requires(is_user_defined_v<T>)
   {
-    return omp.at(typeid(T)).single;
+    return omp.at<T>().single;
   }
 
   static constexpr uint32_t apply()
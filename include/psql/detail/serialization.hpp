@@ -8,6 +8,8 @@
 #include <boost/pfr.hpp>
 
 #include <array>
+#include <span>
+#include <vector>
 
 namespace psql
 {
@@ -16,20 +18,82 @@ namespace detail
 template<class T>
 struct serialize_impl;
 
+// Appends the binary representation of the value to the buffer, which may grow and reallocate meanwhile.
 template<typename T>
-const char* serialize(const oid_map& omp, std::string& buffer, const T& v)
+void serialize(const oid_map& omp, std::string& buffer, const T& v)
 {
-  const char* ret = &buffer.front() + buffer.size();
   serialize_impl<std::decay_t<T>>::apply(omp, buffer, v);
-  return ret;
 }
 
+// Appends the value after an int32 length prefix, which is patched once the value is written, so nested values
+// are walked only once.
+template<typename T>
+void serialize_with_length(const oid_map& omp, std::string& buffer, const T& v)
+{
+  const auto offset = buffer.size();
+  buffer.resize(offset + 4);
+  serialize(omp, buffer, v);
+
+  const auto length = static_cast<int32_t>(buffer.size() - offset - 4);
+  boost::endian::endian_store<int32_t, 4, boost::endian::order::big>(
+    reinterpret_cast<unsigned char*>(buffer.data() + offset), length);
+}
+
+// Variable-length values that are contiguous in memory already, they are passed to libpq without being staged in
+// the buffer.
+template<typename T>
+struct is_contiguous_param : std::false_type
+{
+};
+
+template<typename T>
+  requires(
+    std::is_same_v<T, const char*> || std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string> ||
+    std::is_same_v<T, std::vector<std::byte>> || std::is_same_v<T, std::span<const std::byte>>)
+struct is_contiguous_param<T> : std::true_type
+{
+};
+
+template<typename T>
+constexpr bool is_contiguous_param_v = is_contiguous_param<T>::value;
+
+struct param_slice
+{
+  const char* data; // null if the value is staged in the buffer
+  std::size_t offset;
+  std::size_t length;
+};
+
+template<typename T>
+param_slice serialize_param(const oid_map& omp, std::string& buffer, const T& v)
+{
+  if constexpr (is_contiguous_param_v<std::decay_t<T>>)
+  {
+    const auto length = size_of(v);
+
+    // A null pointer would be sent as NULL, which empty views may have.
+    if (length == 0)
+      return { "", 0, 0 };
+
+    if constexpr (std::is_same_v<std::decay_t<T>, const char*>)
+      return { v, 0, length };
+    else
+      return { reinterpret_cast<const char*>(std::data(v)), 0, length };
+  }
+  else
+  {
+    const auto offset = buffer.size();
+    serialize(omp, buffer, v);
+    return { nullptr, offset, buffer.size() - offset };
+  }
+}
+
+// Serializes only the values of the parameters, for statements whose parameter types are already known.
 template<typename... Ts>
-auto serialize(const oid_map& omp, std::string& buffer, const params<Ts...>& params)
+auto serialize_values(const oid_map& omp, std::string& buffer, const params<Ts...>& params)
 {
   struct result_type
   {
-    std::array<uint32_t, sizeof...(Ts)> types;
     std::array<const char*, sizeof...(Ts)> values;
     std::array<int, sizeof...(Ts)> lengths;
     std::array<int, sizeof...(Ts)> formats;
@@ -39,16 +103,37 @@ auto serialize(const oid_map& omp, std::string& buffer, const params<Ts...>& par
     [&](const auto&... args)
     {
       buffer.clear();
-      buffer.reserve((0 + ... + size_of(args)));
 
-      return result_type{ { oid_of<decltype(args)>(omp)... },
-                          { serialize(omp, buffer, args)... },
-                          { static_cast<int>(size_of(args))... },
-                          { ((void)args, true)... } };
+      const auto slices = std::array<param_slice, sizeof...(Ts)>{ serialize_param(omp, buffer, args)... };
+      auto result       = result_type{ {}, {}, { ((void)args, true)... } };
+
+      // The buffer is complete, so the pointers into it can't be invalidated anymore.
+      for (std::size_t i = 0; i < slices.size(); i++)
+      {
+        result.values[i]  = slices[i].data ? slices[i].data : buffer.data() + slices[i].offset;
+        result.lengths[i] = static_cast<int>(slices[i].length);
+      }
+
+      return result;
     },
     static_cast<const std::tuple<Ts...>&>(params));
 }
 
+template<typename... Ts>
+auto serialize(const oid_map& omp, std::string& buffer, const params<Ts...>& params)
+{
+  struct result_type
+  {
+    std::array<uint32_t, sizeof...(Ts)> types;
+    std::array<const char*, sizeof...(Ts)> values;
+    std::array<int, sizeof...(Ts)> lengths;
+    std::array<int, sizeof...(Ts)> formats;
+  };
+
+  auto [v, l, f] = serialize_values(omp, buffer, params);
+  return result_type{ { oid_of<Ts>(omp)... }, v, l, f };
+}
+
 template<typename T>
   requires(std::is_integral_v<T> || std::is_floating_point_v<T> || std::is_same_v<T, std::byte>)
 struct serialize_impl<T>
@@ -73,6 +158,70 @@ struct serialize_impl<std::chrono::system_clock::time_point>
   }
 };
 
+// Dates are sent as the number of days since 2000-01-01.
+template<>
+struct serialize_impl<std::chrono::sys_days>
+{
+  static void apply(const oid_map& omp, std::string& buffer, const std::chrono::sys_days& value)
+  {
+    serialize<int32_t>(omp, buffer, static_cast<int32_t>(value.time_since_epoch().count() - 10957));
+  }
+};
+
+template<>
+struct serialize_impl<timestamptz>
+{
+  static void apply(const oid_map& omp, std::string& buffer, const timestamptz& value)
+  {
+    serialize(omp, buffer, value.time);
+  }
+};
+
+template<>
+struct serialize_impl<interval>
+{
+  static void apply(const oid_map& omp, std::string& buffer, const interval& value)
+  {
+    serialize<int64_t>(omp, buffer, value.time.count());
+    serialize<int32_t>(omp, buffer, value.days);
+    serialize<int32_t>(omp, buffer, value.months);
+  }
+};
+
+template<>
+struct serialize_impl<uuid>
+{
+  static void apply(const oid_map&, std::string& buffer, const uuid& value)
+  {
+    buffer.append(reinterpret_cast<const char*>(value.bytes.data()), value.bytes.size());
+  }
+};
+
+template<>
+struct serialize_impl<numeric>
+{
+  static void apply(const oid_map& omp, std::string& buffer, const numeric& value)
+  {
+    serialize<int16_t>(omp, buffer, static_cast<int16_t>(value.digits.size()));
+    serialize<int16_t>(omp, buffer, value.weight);
+    serialize<uint16_t>(omp, buffer, value.sign);
+    serialize<uint16_t>(omp, buffer, value.dscale);
+    for (auto digit : value.digits)
+      serialize<int16_t>(omp, buffer, digit);
+  }
+};
+
+// The text is preceded by the version of the jsonb format.
+template<>
+struct serialize_impl<jsonb_view>
+{
+  static void apply(const oid_map&, std::string& buffer, const jsonb_view& value)
+  {
+    buffer += '\1';
+    buffer.append(value.json);
+  }
+};
+
 template<>
 struct serialize_impl<const char*>
 {
@@ -100,6 +249,24 @@ struct serialize_impl<std::string>
   }
 };
 
+template<>
+struct serialize_impl<std::vector<std::byte>>
+{
+  static void apply(const oid_map&, std::string& buffer, const std::vector<std::byte>& value)
+  {
+    buffer.append(reinterpret_cast<const char*>(value.data()), value.size());
+  }
+};
+
+template<>
+struct serialize_impl<std::span<const std::byte>>
+{
+  static void apply(const oid_map&, std::string& buffer, const std::span<const std::byte>& value)
+  {
+    buffer.append(reinterpret_cast<const char*>(value.data()), value.size());
+  }
+};
+
 template<typename T>
   requires(is_composite_v<T>)
 struct serialize_impl<T>
@@ -108,8 +275,7 @@ struct serialize_impl<T>
   static void serialize_member(const oid_map& omp, std::string& buffer, const U& value)
   {
     serialize<int32_t>(omp, buffer, oid_of<U>(omp));
-    serialize<int32_t>(omp, buffer, size_of(value));
-    serialize(omp, buffer, value);
+    serialize_with_length(omp, buffer, value);
   }
 
   static void apply(const oid_map& omp, std::string& buffer, const T& value)
@@ -142,10 +308,7 @@ struct serialize_impl<T>
     serialize<int32_t>(omp, buffer, 0);
 
     for (const auto& value : array)
-    {
-      serialize<int32_t>(omp, buffer, size_of(value));
-      serialize(omp, buffer, value);
-    }
+      serialize_with_length(omp, buffer, value);
   }
 };
 } // namespace detail
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <psql/detail/type_traits.hpp>
+#include <psql/types.hpp>
 
 #include <chrono>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <boost/pfr.hpp>
 
@@ -67,6 +70,78 @@ struct size_of_impl<std::string>
   }
 };
 
+template<>
+struct size_of_impl<std::vector<std::byte>>
+{
+  static constexpr std::size_t apply(const std::vector<std::byte>& value)
+  {
+    return value.size();
+  }
+};
+
+template<>
+struct size_of_impl<std::span<const std::byte>>
+{
+  static constexpr std::size_t apply(const std::span<const std::byte>& value)
+  {
+    return value.size();
+  }
+};
+
+template<>
+struct size_of_impl<uuid>
+{
+  static constexpr std::size_t apply(const uuid&)
+  {
+    return 16;
+  }
+};
+
+template<>
+struct size_of_impl<numeric>
+{
+  static constexpr std::size_t apply(const numeric& value)
+  {
+    return 8 + 2 * value.digits.size();
+  }
+};
+
+template<>
+struct size_of_impl<jsonb_view>
+{
+  static constexpr std::size_t apply(const jsonb_view& value)
+  {
+    return 1 + value.json.size();
+  }
+};
+
+template<>
+struct size_of_impl<std::chrono::sys_days>
+{
+  static constexpr std::size_t apply(const std::chrono::sys_days&)
+  {
+    return 4;
+  }
+};
+
+template<>
+struct size_of_impl<interval>
+{
+  static constexpr std::size_t apply(const interval&)
+  {
+    return 16;
+  }
+};
+
+template<>
+struct size_of_impl<timestamptz>
+{
+  static constexpr std::size_t apply(const timestamptz&)
+  {
+    return 8;
+  }
+};
+
 template<typename T>
   requires(is_array_v<T>)
 struct size_of_impl<T>
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <iterator>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace psql
+{
+namespace detail
+{
+// Maps query texts and the Oids of their parameters to the names of the statements prepared for them, evicting the
+// least recently used ones. Names of evicted statements are kept until they are deallocated on the server.
+class statement_cache
+{
+  struct entry
+  {
+    std::string key;
+    std::string stmt_name;
+  };
+
+  std::list<entry> entries_; // most recently used first
+  std::unordered_map<std::string_view, std::list<entry>::iterator> index_;
+  std::vector<std::string> evicted_;
+  std::string key_buffer_; // reused by make_key, so looking up a statement doesn't allocate
+  size_t capacity_{};
+  size_t next_id_{};
+
+public:
+  // The parameter types are fixed when a statement is prepared, so the same query with parameters of other types
+  // needs a statement of its own. The key is valid until the next call.
+  template<typename Oids>
+  std::string_view make_key(std::string_view query, const Oids& param_oids)
+  {
+    key_buffer_.clear();
+    key_buffer_.reserve(query.size() + 1 + std::size(param_oids) * sizeof(*std::begin(param_oids)));
+    key_buffer_.append(query);
+    key_buffer_ += '\0';
+    for (const auto& oid : param_oids)
+      key_buffer_.append(reinterpret_cast<const char*>(&oid), sizeof(oid));
+    return key_buffer_;
+  }
+
+  size_t capacity() const noexcept
+  {
+    return capacity_;
+  }
+
+  void capacity(size_t value)
+  {
+    capacity_ = value;
+    evict_overflow();
+  }
+
+  size_t size() const noexcept
+  {
+    return entries_.size();
+  }
+
+  const std::string* find(std::string_view key) noexcept
+  {
+    if (auto it = index_.find(key); it != index_.end())
+    {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return &it->second->stmt_name;
+    }
+    return nullptr;
+  }
+
+  const std::string& insert(std::string_view key)
+  {
+    auto& e = entries_.emplace_front(std::string{ key }, "psql_stmt_" + std::to_string(next_id_++));
+    index_.emplace(e.key, entries_.begin());
+    evict_overflow();
+    return e.stmt_name;
+  }
+
+  // Removes the entry without deallocating it, for statements that no longer exist on the server.
+  void erase(std::string_view key)
+  {
+    if (auto it = index_.find(key); it != index_.end())
+    {
+      auto entry_it = it->second;
+      index_.erase(it);
+      entries_.erase(entry_it);
+    }
+  }
+
+  // Removes the entry and schedules its deallocation, for statements whose state on the server is unknown.
+  void evict(std::string_view key)
+  {
+    if (auto it = index_.find(key); it != index_.end())
+    {
+      auto entry_it = it->second;
+      index_.erase(it);
+      evicted_.push_back(std::move(entry_it->stmt_name));
+      entries_.erase(entry_it);
+    }
+  }
+
+  std::vector<std::string> take_evicted() noexcept
+  {
+    return std::exchange(evicted_, {});
+  }
+
+private:
+  void evict_overflow()
+  {
+    while (entries_.size() > capacity_)
+    {
+      index_.erase(entries_.back().key);
+      evicted_.push_back(std::move(entries_.back().stmt_name));
+      entries_.pop_back();
+    }
+  }
+};
+} // namespace detail
+} // namespace psql
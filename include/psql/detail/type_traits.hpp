@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <tuple>
 #include <vector>
 
@@ -35,6 +36,12 @@ struct is_array<std::vector<T>> : std::true_type
 {
 };
 
+// Mapped to bytea rather than to an array of single bytes.
+template<>
+struct is_array<std::vector<std::byte>> : std::false_type
+{
+};
+
 template<typename T, std::size_t N>
 struct is_array<std::array<T, N>> : std::true_type
 {
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <typeindex>
+#include <cstddef>
 #include <string_view>
 
 namespace psql
@@ -10,7 +10,7 @@ namespace detail
 struct udt_pair
 {
   std::string_view name;
-  std::type_index type_index;
+  std::size_t slot;
 };
 } // namespace detail
 } // namespace psql
@@ -27,6 +27,22 @@ enum class error
   unexpected_non_null_result,
   exception_in_pipeline_operation,
   user_defined_type_does_not_exist,
+  pq_send_flush_request_failed,
+  pq_set_single_row_mode_failed,
+  pq_set_chunked_rows_mode_failed,
+  pq_put_copy_data_failed,
+  pq_put_copy_end_failed,
+  pq_get_copy_data_failed,
+  no_pending_pipeline_result,
+  unexpected_copy_data_format,
+  field_does_not_exist,
+  mismatched_field_type,
+  mismatched_composite_member_count,
+  pq_cancel_failed,
+  invalid_conninfo,
+  no_host_available,
+  exception_in_row_handler,
+  pipeline_mode_in_use,
 };
 
 inline const boost::system::error_category& error_category()
@@ -86,6 +102,38 @@ inline const boost::system::error_category& error_category()
           return "An exception occurred while executing the pipeline operation";
         case error::user_defined_type_does_not_exist:
           return "No user-defined type with the given name was found on the server";
+        case error::pq_send_flush_request_failed:
+          return "PQsendFlushRequest failed, check the error message on the connection";
+        case error::pq_set_single_row_mode_failed:
+          return "PQsetSingleRowMode failed, check the error message on the connection";
+        case error::pq_set_chunked_rows_mode_failed:
+          return "PQsetChunkedRowsMode failed, check the error message on the connection";
+        case error::pq_put_copy_data_failed:
+          return "PQputCopyData failed, check the error message on the connection";
+        case error::pq_put_copy_end_failed:
+          return "PQputCopyEnd failed, check the error message on the connection";
+        case error::pq_get_copy_data_failed:
+          return "PQgetCopyData failed, check the error message on the connection";
+        case error::no_pending_pipeline_result:
+          return "There is no pending query in the pipeline to receive a result for";
+        case error::unexpected_copy_data_format:
+          return "The COPY data does not match the binary format of the expected row type";
+        case error::field_does_not_exist:
+          return "The result has no field for a member of the mapped type";
+        case error::mismatched_field_type:
+          return "The type of a field does not match the type of the mapped member";
+        case error::mismatched_composite_member_count:
+          return "The member count of a composite field does not match the mapped member";
+        case error::pq_cancel_failed:
+          return "The cancel request could not be sent to the server";
+        case error::invalid_conninfo:
+          return "The connection string could not be parsed";
+        case error::no_host_available:
+          return "No host is available for the requested access mode";
+        case error::exception_in_row_handler:
+          return "An exception was thrown by the row handler";
+        case error::pipeline_mode_in_use:
+          return "The connection is in pipeline mode already, which this operation can't share";
         default:
           return "Unknown error";
       }
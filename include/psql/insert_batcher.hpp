@@ -0,0 +1,193 @@
+#pragma once
+
+#include <psql/connection_pool.hpp>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace psql
+{
+struct insert_batcher_options
+{
+  // A batch is flushed once it has this many rows, or once its first row has waited for max_delay.
+  size_t max_batch_rows                         = 1024;
+  std::chrono::steady_clock::duration max_delay = std::chrono::milliseconds{ 5 };
+};
+
+namespace detail
+{
+template<typename Row, typename Executor>
+class basic_insert_batcher_impl : public std::enable_shared_from_this<basic_insert_batcher_impl<Row, Executor>>
+{
+  using error_code             = boost::system::error_code;
+  using pooled_connection_type = basic_pooled_connection<Executor>;
+
+  struct batch
+  {
+    std::vector<Row> rows;
+    std::vector<asio::any_completion_handler<void(error_code)>> handlers;
+
+    void complete(error_code ec)
+    {
+      for (auto& handler : handlers)
+        asio::post(asio::append(std::move(handler), ec));
+    }
+  };
+
+  std::mutex mtx_;
+  basic_connection_pool<Executor> pool_;
+  std::string query_;
+  insert_batcher_options options_;
+  asio::steady_timer timer_;
+  std::shared_ptr<batch> pending_;
+  size_t batch_id_{}; // identifies the pending batch, so a timer that fired late doesn't flush the next one
+
+public:
+  basic_insert_batcher_impl(basic_connection_pool<Executor> pool, std::string query, insert_batcher_options options)
+    : pool_{ std::move(pool) }
+    , query_{ std::move(query) }
+    , options_{ options }
+    , timer_{ pool_.get_executor() }
+  {
+  }
+
+  basic_connection_pool<Executor>& pool() noexcept
+  {
+    return pool_;
+  }
+
+  void async_insert_erased(Row row, asio::any_completion_handler<void(error_code)> handler)
+  {
+    auto lg = std::unique_lock<std::mutex>{ mtx_ };
+
+    if (!pending_)
+    {
+      pending_ = std::make_shared<batch>();
+      pending_->rows.reserve(options_.max_batch_rows);
+      schedule_flush(++batch_id_);
+    }
+
+    pending_->rows.push_back(std::move(row));
+    pending_->handlers.push_back(std::move(handler));
+
+    if (pending_->rows.size() < options_.max_batch_rows)
+      return;
+
+    auto full = std::move(pending_);
+    lg.unlock();
+    flush(std::move(full));
+  }
+
+  void flush()
+  {
+    auto lg      = std::unique_lock<std::mutex>{ mtx_ };
+    auto pending = std::move(pending_);
+    lg.unlock();
+
+    if (pending)
+      flush(std::move(pending));
+  }
+
+private:
+  // Must be called with mtx_ held.
+  void schedule_flush(size_t id)
+  {
+    timer_.expires_after(options_.max_delay);
+    timer_.async_wait(
+      [wp = this->weak_from_this(), id](error_code ec)
+      {
+        auto sp = wp.lock();
+        if (!sp || ec)
+          return;
+
+        auto lg      = std::unique_lock<std::mutex>{ sp->mtx_ };
+        auto pending = id == sp->batch_id_ ? std::move(sp->pending_) : nullptr;
+        lg.unlock();
+
+        if (pending)
+          sp->flush(std::move(pending));
+      });
+  }
+
+  // The whole batch is sent in a single COPY on one connection, so its rows are committed or rejected together.
+  void flush(std::shared_ptr<batch> b)
+  {
+    pool_.async_aquire(
+      [sp = this->shared_from_this(), b = std::move(b)](error_code ec, pooled_connection_type conn) mutable
+      {
+        if (ec)
+          return b->complete(ec);
+
+        // The connection can't be moved while the COPY is in progress on it.
+        auto pc = std::make_shared<pooled_connection_type>(std::move(conn));
+        (*pc)->async_copy_in(sp->query_, b->rows, [pc, b](error_code ec, result) { b->complete(ec); });
+      });
+  }
+};
+} // namespace detail
+
+// Coalesces rows inserted from many operations into batches, each sent in a single binary COPY on a connection of
+// the pool. An insert completes once the COPY of its batch has committed, or with the error that failed the whole
+// batch. Batches are flushed in parallel, up to the size of the pool. The rows still pending when the batcher is
+// destroyed are flushed.
+template<typename Row, typename Executor = asio::any_io_executor>
+class basic_insert_batcher
+{
+  using error_code = boost::system::error_code;
+  using impl_type  = detail::basic_insert_batcher_impl<Row, Executor>;
+
+  std::shared_ptr<impl_type> impl_;
+
+public:
+  using executor_type = Executor;
+
+  // The query must be a `COPY ... FROM STDIN (FORMAT BINARY)` whose columns correspond to the fields of Row.
+  basic_insert_batcher(basic_connection_pool<Executor> pool, std::string query, insert_batcher_options options = {})
+    : impl_{ std::make_shared<impl_type>(std::move(pool), std::move(query), options) }
+  {
+  }
+
+  basic_insert_batcher(basic_insert_batcher&&) noexcept = default;
+  basic_insert_batcher& operator=(basic_insert_batcher&& other) noexcept
+  {
+    std::swap(impl_, other.impl_);
+    return *this;
+  }
+
+  ~basic_insert_batcher()
+  {
+    if (impl_)
+      impl_->flush();
+  }
+
+  executor_type get_executor() const noexcept
+  {
+    return impl_->pool().get_executor();
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_insert(Row row, CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_initiate<CompletionToken, void(error_code)>(
+      [](auto handler, std::shared_ptr<impl_type> impl, Row row)
+      { impl->async_insert_erased(std::move(row), std::move(handler)); },
+      token,
+      impl_,
+      std::move(row));
+  }
+
+  // Sends the pending batch now instead of waiting for it to fill up or for max_delay to pass.
+  void flush()
+  {
+    impl_->flush();
+  }
+};
+
+template<typename Row>
+using insert_batcher = basic_insert_batcher<Row>;
+} // namespace psql
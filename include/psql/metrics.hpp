@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+namespace psql
+{
+// Durations counted in power-of-two buckets: bucket 0 holds durations under 1us, bucket i those in
+// [2^(i-1), 2^i) microseconds, and the last one everything longer.
+struct histogram
+{
+  static constexpr std::size_t num_buckets = 32;
+
+  std::array<std::uint64_t, num_buckets> buckets{};
+  std::uint64_t count{};
+  std::chrono::microseconds sum{};
+
+  // The upper bound of the bucket containing the quantile, e.g. quantile(0.99) for p99.
+  std::chrono::microseconds quantile(double q) const noexcept
+  {
+    if (count == 0)
+      return {};
+
+    auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * count)));
+    auto seen = std::uint64_t{};
+
+    for (std::size_t i = 0; i < num_buckets - 1; i++)
+    {
+      if ((seen += buckets[i]) >= rank)
+        return std::chrono::microseconds{ std::int64_t{ 1 } << i };
+    }
+    return std::chrono::microseconds::max();
+  }
+};
+
+struct connection_metrics
+{
+  histogram operation_latency;
+  std::uint64_t num_operations{};
+  std::uint64_t num_failed_operations{};
+  std::uint64_t bytes_sent{};     // query texts, parameters and COPY data
+  std::uint64_t bytes_received{}; // memory of the received results and COPY data
+  // Heap allocations of the intermediate states of operations whose handler has no allocator of its own, made from
+  // the memory recycled by the connection, stops growing once warmed up. Nothing else is counted: the query strings
+  // and results, and the statements prepared on cache misses, are allocated as usual.
+  std::uint64_t num_handler_allocations{};
+};
+
+struct pool_metrics
+{
+  histogram aquire_wait; // including the time spent on opening a new connection
+  histogram connect_latency;
+  std::uint64_t num_aquires{};
+  std::uint64_t num_aquire_cancellations{};
+  std::uint64_t num_connect_failures{};
+  std::uint64_t num_discarded{}; // returned with a bad connection status or within a transaction
+  std::uint64_t num_expired{};   // closed by idle_timeout or max_lifetime
+  std::size_t num_aquired{};
+  std::size_t num_idle{};
+};
+
+namespace detail
+{
+// Metrics are updated with relaxed atomics, they only need to be eventually consistent with each other.
+inline void increment(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) noexcept
+{
+  counter.fetch_add(n, std::memory_order_relaxed);
+}
+
+inline std::uint64_t load(const std::atomic<std::uint64_t>& counter) noexcept
+{
+  return counter.load(std::memory_order_relaxed);
+}
+
+class histogram_recorder
+{
+  std::array<std::atomic<std::uint64_t>, histogram::num_buckets> buckets_{};
+  std::atomic<std::uint64_t> count_{};
+  std::atomic<std::uint64_t> sum_{};
+
+public:
+  void record(std::chrono::steady_clock::duration duration) noexcept
+  {
+    auto us     = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    auto bucket = std::min<std::size_t>(std::bit_width(us), histogram::num_buckets - 1);
+
+    increment(buckets_[bucket]);
+    increment(count_);
+    increment(sum_, us);
+  }
+
+  void record_since(std::chrono::steady_clock::time_point start) noexcept
+  {
+    record(std::chrono::steady_clock::now() - start);
+  }
+
+  histogram snapshot() const noexcept
+  {
+    auto result = histogram{};
+    add_to(result);
+    return result;
+  }
+
+  void add_to(histogram& result) const noexcept
+  {
+    for (std::size_t i = 0; i < histogram::num_buckets; i++)
+      result.buckets[i] += load(buckets_[i]);
+    result.count += load(count_);
+    result.sum += std::chrono::microseconds{ load(sum_) };
+  }
+};
+
+// Threads are assigned to shards round-robin on their first use, so they rarely share one.
+inline std::size_t thread_shard_index(std::size_t num_shards) noexcept
+{
+  static auto next_index           = std::atomic<std::size_t>{};
+  static thread_local const auto i = next_index.fetch_add(1, std::memory_order_relaxed);
+  return i % num_shards;
+}
+
+struct connection_metrics_recorder
+{
+  histogram_recorder operation_latency;
+  std::atomic<std::uint64_t> num_operations{};
+  std::atomic<std::uint64_t> num_failed_operations{};
+  std::atomic<std::uint64_t> bytes_sent{};
+  std::atomic<std::uint64_t> bytes_received{};
+
+  connection_metrics snapshot() const noexcept
+  {
+    return { operation_latency.snapshot(),
+             load(num_operations),
+             load(num_failed_operations),
+             load(bytes_sent),
+             load(bytes_received) };
+  }
+};
+
+// The metrics of a pool are updated by all the threads that aquire and return its connections, so each thread
+// updates a shard on cache lines of its own, and snapshot sums up the shards. A connection is only used by one
+// thread at a time, its metrics aren't sharded.
+class pool_metrics_recorder
+{
+public:
+  struct alignas(64) shard
+  {
+    histogram_recorder aquire_wait;
+    histogram_recorder connect_latency;
+    std::atomic<std::uint64_t> num_aquires{};
+    std::atomic<std::uint64_t> num_aquire_cancellations{};
+    std::atomic<std::uint64_t> num_connect_failures{};
+    std::atomic<std::uint64_t> num_discarded{};
+    std::atomic<std::uint64_t> num_expired{};
+  };
+
+private:
+  static constexpr std::size_t num_shards = 16;
+
+  std::unique_ptr<shard[]> shards_ = std::make_unique<shard[]>(num_shards);
+
+public:
+  // The shard of the calling thread.
+  shard& local() noexcept
+  {
+    return shards_[thread_shard_index(num_shards)];
+  }
+
+  pool_metrics snapshot(std::size_t num_aquired, std::size_t num_idle) const noexcept
+  {
+    auto result = pool_metrics{};
+    for (std::size_t i = 0; i < num_shards; i++)
+    {
+      const auto& s = shards_[i];
+      s.aquire_wait.add_to(result.aquire_wait);
+      s.connect_latency.add_to(result.connect_latency);
+      result.num_aquires += load(s.num_aquires);
+      result.num_aquire_cancellations += load(s.num_aquire_cancellations);
+      result.num_connect_failures += load(s.num_connect_failures);
+      result.num_discarded += load(s.num_discarded);
+      result.num_expired += load(s.num_expired);
+    }
+    result.num_aquired = num_aquired;
+    result.num_idle    = num_idle;
+    return result;
+  }
+};
+} // namespace detail
+} // namespace psql
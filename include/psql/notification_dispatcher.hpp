@@ -0,0 +1,432 @@
+#pragma once
+
+#include <psql/connection.hpp>
+#include <psql/detail/escape_identifier.hpp>
+
+#include <boost/asio/associated_cancellation_slot.hpp>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace psql
+{
+namespace detail
+{
+struct channel_hash
+{
+  using is_transparent = void;
+
+  size_t operator()(std::string_view channel) const noexcept
+  {
+    return std::hash<std::string_view>{}(channel);
+  }
+};
+
+struct notification_subscriber
+{
+  using error_code = boost::system::error_code;
+
+  std::string channel;
+  std::deque<std::shared_ptr<const notification>> notifications;
+  asio::any_completion_handler<void(error_code, std::shared_ptr<const notification>)> handler;
+  error_code closed_ec;
+
+  void deliver(error_code ec, std::shared_ptr<const notification> notif)
+  {
+    asio::get_associated_cancellation_slot(handler).clear();
+    asio::post(asio::append(std::move(handler), ec, std::move(notif)));
+  }
+};
+
+struct notification_channel
+{
+  using error_code = boost::system::error_code;
+
+  std::vector<std::shared_ptr<notification_subscriber>> subscribers;
+  std::vector<asio::any_completion_handler<void(error_code)>> listen_waiters; // later subscribers, until LISTEN is done
+  bool is_listening{};
+
+  void complete_listen_waiters(error_code ec)
+  {
+    for (auto& handler : std::exchange(listen_waiters, {}))
+      asio::post(asio::append(std::move(handler), ec));
+  }
+};
+
+template<typename Executor>
+class basic_notification_dispatcher_impl
+  : public std::enable_shared_from_this<basic_notification_dispatcher_impl<Executor>>
+{
+  using error_code      = boost::system::error_code;
+  using connection_type = basic_connection<Executor>;
+
+  struct listen_command
+  {
+    std::string query;
+    asio::any_completion_handler<void(error_code)> handler; // empty for UNLISTEN
+  };
+
+  connection_type& conn_;
+  std::unordered_map<std::string, notification_channel, channel_hash, std::equal_to<>> channels_;
+  std::deque<listen_command> commands_;
+  bool is_sending_commands_{};
+
+public:
+  explicit basic_notification_dispatcher_impl(connection_type& conn)
+    : conn_{ conn }
+  {
+  }
+
+  connection_type& connection() noexcept
+  {
+    return conn_;
+  }
+
+  size_t num_channels() const noexcept
+  {
+    return channels_.size();
+  }
+
+  // The subscriber is registered right away, so notifications that arrive once LISTEN has taken effect aren't lost.
+  // Subscribers of a channel whose LISTEN is still in flight wait for it and share its outcome.
+  template<typename CompletionToken>
+  auto async_subscribe(std::shared_ptr<notification_subscriber> subscriber, CompletionToken&& token)
+  {
+    auto [it, inserted] = channels_.try_emplace(subscriber->channel);
+    it->second.subscribers.push_back(subscriber);
+
+    return asio::async_compose<CompletionToken, void(error_code)>(
+      [this, inserted, coro = asio::coroutine{}, subscriber = std::move(subscriber)](
+        auto& self, error_code ec = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if (!inserted)
+          {
+            BOOST_ASIO_CORO_YIELD async_wait_for_listen(subscriber->channel, std::move(self));
+            return self.complete(ec);
+          }
+
+          BOOST_ASIO_CORO_YIELD async_send_command(listen_query("LISTEN ", subscriber->channel), std::move(self));
+
+          if (auto it = channels_.find(subscriber->channel); it != channels_.end())
+          {
+            it->second.is_listening = !ec;
+            it->second.complete_listen_waiters(ec);
+
+            // Nobody listens to the channel, all of its subscribers fail along with the LISTEN.
+            if (ec)
+              channels_.erase(it);
+          }
+
+          return self.complete(ec);
+        }
+      },
+      token,
+      conn_);
+  }
+
+  // Sends UNLISTEN once the last subscriber of a channel is gone.
+  void unsubscribe(notification_subscriber& subscriber, bool unlisten = true)
+  {
+    auto it = channels_.find(subscriber.channel);
+    if (it == channels_.end())
+      return;
+
+    std::erase_if(it->second.subscribers, [&](const auto& s) { return s.get() == &subscriber; });
+
+    if (it->second.subscribers.empty())
+    {
+      if (unlisten)
+        send_command(listen_query("UNLISTEN ", it->first), {});
+      channels_.erase(it);
+    }
+  }
+
+  template<typename CompletionToken>
+  auto async_run(CompletionToken&& token)
+  {
+    return asio::async_compose<CompletionToken, void(error_code)>(
+      [this, sp = this->shared_from_this(), coro = asio::coroutine{}](
+        auto& self, error_code ec = {}, std::vector<notification> notifications = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          for (;;)
+          {
+            BOOST_ASIO_CORO_YIELD conn_.async_receive_notifications(std::move(self));
+
+            if (ec)
+            {
+              close_subscribers(ec);
+              return self.complete(ec);
+            }
+
+            for (auto& notif : notifications)
+              dispatch(std::move(notif));
+          }
+        }
+      },
+      token,
+      conn_);
+  }
+
+private:
+  template<typename CompletionToken>
+  auto async_send_command(std::string query, CompletionToken&& token)
+  {
+    return asio::async_initiate<CompletionToken, void(error_code)>(
+      [this](auto handler, std::string query) { send_command(std::move(query), std::move(handler)); },
+      token,
+      std::move(query));
+  }
+
+  // LISTEN and UNLISTEN are sent one at a time in the order of the subscriptions, so the mode of the connection is
+  // left to the caller.
+  void send_command(std::string query, asio::any_completion_handler<void(error_code)> handler)
+  {
+    commands_.push_back({ std::move(query), std::move(handler) });
+    if (!std::exchange(is_sending_commands_, true))
+      send_next_command();
+  }
+
+  void send_next_command()
+  {
+    if (commands_.empty())
+    {
+      is_sending_commands_ = false;
+      return;
+    }
+
+    conn_.async_query(
+      commands_.front().query,
+      [this, sp = this->shared_from_this()](error_code ec, result)
+      {
+        auto handler = std::move(commands_.front().handler);
+        commands_.pop_front();
+
+        if (handler)
+          asio::post(asio::append(std::move(handler), ec));
+
+        send_next_command();
+      });
+  }
+
+  template<typename CompletionToken>
+  auto async_wait_for_listen(std::string_view channel, CompletionToken&& token)
+  {
+    return asio::async_initiate<CompletionToken, void(error_code)>(
+      [this](auto handler, std::string_view channel)
+      {
+        auto it = channels_.find(channel);
+        if (it == channels_.end())
+          return asio::post(asio::append(std::move(handler), error_code{ asio::error::operation_aborted }));
+
+        if (it->second.is_listening)
+          return asio::post(asio::append(std::move(handler), error_code{}));
+
+        it->second.listen_waiters.push_back(std::move(handler));
+      },
+      token,
+      channel);
+  }
+
+  std::string listen_query(std::string_view command, std::string_view channel)
+  {
+    return std::string{ command } + detail::escape_identifier(conn_.native_handle(), channel);
+  }
+
+  // A notification is shared by all the subscribers of its channel instead of being copied for each of them.
+  void dispatch(notification&& notif)
+  {
+    auto it = channels_.find(notif.channel());
+    if (it == channels_.end())
+      return;
+
+    auto shared = std::make_shared<const notification>(std::move(notif));
+    for (const auto& subscriber : it->second.subscribers)
+    {
+      if (subscriber->handler)
+        subscriber->deliver({}, shared);
+      else
+        subscriber->notifications.push_back(shared);
+    }
+  }
+
+  void close_subscribers(error_code ec)
+  {
+    for (auto& [_, channel] : channels_)
+    {
+      for (const auto& subscriber : channel.subscribers)
+      {
+        subscriber->closed_ec = ec;
+        if (subscriber->handler)
+          subscriber->deliver(ec, nullptr);
+      }
+    }
+  }
+};
+} // namespace detail
+
+// A subscription to a channel of a notification_dispatcher. Stops listening to the channel when the last
+// subscription to it is destroyed.
+template<typename Executor = asio::any_io_executor>
+class basic_notification_subscription
+{
+  using error_code = boost::system::error_code;
+  using impl_type  = detail::basic_notification_dispatcher_impl<Executor>;
+
+  std::weak_ptr<impl_type> impl_;
+  std::shared_ptr<detail::notification_subscriber> subscriber_;
+
+public:
+  basic_notification_subscription() = default;
+
+  basic_notification_subscription(std::weak_ptr<impl_type> impl, std::shared_ptr<detail::notification_subscriber> s)
+    : impl_{ std::move(impl) }
+    , subscriber_{ std::move(s) }
+  {
+  }
+
+  basic_notification_subscription(basic_notification_subscription&&) noexcept = default;
+
+  basic_notification_subscription& operator=(basic_notification_subscription&& other) noexcept
+  {
+    if (this != &other)
+    {
+      unsubscribe();
+      impl_       = std::move(other.impl_);
+      subscriber_ = std::move(other.subscriber_);
+    }
+    return *this;
+  }
+
+  ~basic_notification_subscription()
+  {
+    unsubscribe();
+  }
+
+  // Empty for a default-constructed or moved-from subscription.
+  std::string_view channel() const noexcept
+  {
+    return subscriber_ ? std::string_view{ subscriber_->channel } : std::string_view{};
+  }
+
+  // Completes with the next notification of the channel, or with the error that ended the dispatcher. Only one
+  // receive can be pending at a time.
+  template<typename CompletionToken = asio::default_completion_token_t<Executor>>
+  auto async_receive(CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_initiate<CompletionToken, void(error_code, std::shared_ptr<const notification>)>(
+      [](auto handler, std::shared_ptr<detail::notification_subscriber> s)
+      {
+        if (!s)
+          return asio::post(asio::append(std::move(handler), error_code{ asio::error::bad_descriptor }, nullptr));
+
+        s->handler = std::move(handler);
+
+        if (!s->notifications.empty())
+        {
+          auto notif = std::move(s->notifications.front());
+          s->notifications.pop_front();
+          return s->deliver({}, std::move(notif));
+        }
+
+        if (s->closed_ec)
+          return s->deliver(s->closed_ec, nullptr);
+
+        if (auto slot = asio::get_associated_cancellation_slot(s->handler); slot.is_connected())
+        {
+          slot.assign(
+            [w = std::weak_ptr{ s }](asio::cancellation_type)
+            {
+              if (auto s = w.lock(); s && s->handler)
+                s->deliver(asio::error::operation_aborted, nullptr);
+            });
+        }
+      },
+      token,
+      subscriber_);
+  }
+
+private:
+  void unsubscribe()
+  {
+    if (auto sp = impl_.lock(); sp && subscriber_)
+      sp->unsubscribe(*subscriber_);
+  }
+};
+
+// Multiplexes the notifications received on a single connection into subscriptions to their channels, so many
+// subscribers can share one LISTEN connection. The connection must outlive the dispatcher and be used from a single
+// thread; async_run has to be running for notifications to be delivered. The dispatcher sends its LISTEN and UNLISTEN
+// queries one at a time and doesn't change the mode of the connection.
+template<typename Executor = asio::any_io_executor>
+class basic_notification_dispatcher
+{
+  using error_code = boost::system::error_code;
+  using impl_type  = detail::basic_notification_dispatcher_impl<Executor>;
+
+  std::shared_ptr<impl_type> impl_;
+
+public:
+  using executor_type     = Executor;
+  using subscription_type = basic_notification_subscription<Executor>;
+
+  explicit basic_notification_dispatcher(basic_connection<Executor>& conn)
+    : impl_{ std::make_shared<impl_type>(conn) }
+  {
+  }
+
+  executor_type get_executor() const noexcept
+  {
+    return impl_->connection().get_executor();
+  }
+
+  size_t num_channels() const noexcept
+  {
+    return impl_->num_channels();
+  }
+
+  // Receives and dispatches notifications until an error occurs or the operation is cancelled, then completes the
+  // pending and later receives of all subscriptions with the error.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_run(CompletionToken&& token = CompletionToken{})
+  {
+    return impl_->async_run(std::forward<CompletionToken>(token));
+  }
+
+  // Sends LISTEN for the channel unless it already has subscribers. The channel name is matched exactly, as if it
+  // was quoted.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_subscribe(std::string channel, CompletionToken&& token = CompletionToken{})
+  {
+    auto subscriber     = std::make_shared<detail::notification_subscriber>();
+    subscriber->channel = std::move(channel);
+
+    return asio::async_compose<CompletionToken, void(error_code, subscription_type)>(
+      [impl = impl_, coro = asio::coroutine{}, subscriber](auto& self, error_code ec = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          BOOST_ASIO_CORO_YIELD impl->async_subscribe(subscriber, std::move(self));
+
+          if (ec)
+            return self.complete(ec, {});
+
+          return self.complete({}, subscription_type{ impl, std::move(subscriber) });
+        }
+      },
+      token,
+      impl_->connection());
+  }
+};
+
+using notification_dispatcher   = basic_notification_dispatcher<>;
+using notification_subscription = basic_notification_subscription<>;
+} // namespace psql
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <psql/detail/oid_map.hpp>
+#include <psql/detail/udt_pair.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace psql
+{
+// Oids of user-defined types shared by a number of connections, e.g. the ones of a connection pool, so a type is
+// looked up on the server only once. Connections keep their own copy of the Oids they have used, and consult the
+// cache only for the types they haven't seen yet. Clearing the cache starts a new generation, upon which the
+// connections forget their own copies too.
+class oid_cache
+{
+  mutable std::shared_mutex mtx_;
+  detail::oid_map oids_;
+  std::atomic<std::uint64_t> generation_{};
+
+public:
+  std::uint64_t generation() const noexcept
+  {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+  // Copies the cached Oids of the pending types into omp and removes them from new_udts.
+  void lookup(std::vector<detail::udt_pair>& new_udts, detail::oid_map& omp) const
+  {
+    auto lg = std::shared_lock<std::shared_mutex>{ mtx_ };
+    std::erase_if(
+      new_udts,
+      [&](const detail::udt_pair& udt)
+      {
+        if (const auto* oids = oids_.find(udt.slot))
+        {
+          omp.emplace(udt.slot, *oids);
+          return true;
+        }
+        return false;
+      });
+  }
+
+  void insert(size_t slot, detail::oid_pair oids)
+  {
+    auto lg = std::lock_guard<std::shared_mutex>{ mtx_ };
+    oids_.emplace(slot, oids);
+  }
+
+  // Forgets all the Oids, e.g. after a type got dropped and created again by a schema migration.
+  void clear()
+  {
+    auto lg = std::lock_guard<std::shared_mutex>{ mtx_ };
+    oids_.clear();
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+};
+} // namespace psql
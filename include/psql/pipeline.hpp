@@ -3,19 +3,31 @@
 #include <psql/detail/oid_map.hpp>
 #include <psql/detail/serialization.hpp>
 #include <psql/error.hpp>
+#include <psql/prepared_statement.hpp>
 
 #include <boost/system/system_error.hpp>
 
 #include <libpq-fe.h>
 
+#include <numeric>
+
 namespace psql
 {
+// Bounds the queries of a windowed pipeline that are sent but whose results are not received yet. The size of a
+// query is the size of its text, or statement name, plus the sizes of its parameters.
+struct pipeline_window
+{
+  size_t max_queries = 1024;
+  size_t max_bytes   = 4 * 1024 * 1024;
+};
+
 class pipeline
 {
   PGconn* pgconn_;
   detail::oid_map& oid_map_;
   std::string& buffer_;
   size_t index_{};
+  size_t num_bytes_{};
 
 public:
   pipeline(PGconn* pgconn, detail::oid_map& oid_map, std::string& buffer)
@@ -36,6 +48,7 @@ public:
     if (!PQsendQueryParams(pgconn_, query.data(), t.size(), t.data(), v.data(), l.data(), f.data(), 1))
       throw boost::system::system_error{ error::pq_send_query_params_failed };
 
+    num_bytes_ += query.size() + std::reduce(l.begin(), l.end(), size_t{});
     return index_++;
   }
 
@@ -47,12 +60,24 @@ public:
     if (!PQsendQueryPrepared(pgconn_, stmt_name.data(), t.size(), v.data(), l.data(), f.data(), 1))
       throw boost::system::system_error{ error::pq_send_query_prepared_failed };
 
+    num_bytes_ += stmt_name.size() + std::reduce(l.begin(), l.end(), size_t{});
     return index_++;
   }
 
+  template<typename... Ts>
+  size_t push_query_prepared(const prepared_statement<Ts...>& stmt, std::type_identity_t<params<Ts...>> params = {})
+  {
+    return push_query_prepared(stmt.name(), std::move(params));
+  }
+
   size_t size() const noexcept
   {
     return index_;
   }
+
+  size_t num_bytes() const noexcept
+  {
+    return num_bytes_;
+  }
 };
 } // namespace psql
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <psql/connection.hpp>
+
+#include <cassert>
+
+namespace psql
+{
+// A long-lived pipeline on a connection: queries can be pushed at any time, their results are received in order as
+// they arrive, and sync points are placed explicitly. The connection stays in pipeline mode for the lifetime of the
+// session, and no other operation except async_receive_notifcation can be used on it meanwhile. A session is ended
+// with async_close, which drains the outstanding results and leaves pipeline mode.
+template<typename Executor = asio::any_io_executor>
+class basic_pipeline_session
+{
+  using error_code = boost::system::error_code;
+
+  basic_connection<Executor>& conn_;
+  size_t num_pending_queries_{};
+  size_t num_pending_syncs_{}; // sync points whose results haven't been received yet
+  size_t num_pushed_{};
+  bool needs_flush_request_{};
+  bool needs_sync_{}; // queries were pushed after the last sync point
+  bool is_closed_{};
+
+public:
+  using executor_type = Executor;
+
+  // Enters pipeline mode, throws boost::system::system_error if the connection is not idle or is running an
+  // auto-pipeline.
+  explicit basic_pipeline_session(basic_connection<Executor>& conn)
+    : conn_{ conn }
+  {
+    if (conn_.is_pipeline_in_use())
+      throw boost::system::system_error{ error::pipeline_mode_in_use };
+
+    if (!PQenterPipelineMode(conn_.native_handle()))
+      throw boost::system::system_error{ error::pq_enter_pipeline_mode_failed };
+  }
+
+  basic_pipeline_session(const basic_pipeline_session&) = delete;
+  basic_pipeline_session(basic_pipeline_session&&)      = delete;
+
+  const executor_type& get_executor() noexcept
+  {
+    return conn_.get_executor();
+  }
+
+  // The Oids of user-defined types in the parameters must be already known to the connection or to its shared Oid
+  // cache, e.g. by async_register_types, otherwise error::user_defined_type_does_not_exist is thrown.
+  template<typename... Ts>
+  size_t push_query(const std::string& query, params<Ts...> params = {})
+  {
+    verify_udts_of_params<Ts...>();
+    psql::pipeline{ conn_.pgconn_.get(), conn_.oid_map_, conn_.buffer_ }.push_query(query, std::move(params));
+    return on_pushed();
+  }
+
+  template<typename... Ts>
+  size_t push_query_prepared(const std::string& stmt_name, params<Ts...> params = {})
+  {
+    verify_udts_of_params<Ts...>();
+    psql::pipeline{ conn_.pgconn_.get(), conn_.oid_map_, conn_.buffer_ }.push_query_prepared(
+      stmt_name, std::move(params));
+    return on_pushed();
+  }
+
+  // Ends the implicit transaction of the queries pushed since the previous sync point. A failed query only aborts
+  // the rest of the queries within its own sync segment.
+  void sync()
+  {
+    if (!PQpipelineSync(conn_.native_handle()))
+      throw boost::system::system_error{ error::pq_pipeline_sync_failed };
+
+    num_pending_syncs_++;
+    needs_flush_request_ = false;
+    needs_sync_          = false;
+  }
+
+  size_t num_pending_queries() const noexcept
+  {
+    return num_pending_queries_;
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_flush(CompletionToken&& token = CompletionToken{})
+  {
+    return conn_.async_flush(std::forward<CompletionToken>(token));
+  }
+
+  // Completes with the result of the oldest pending query. Queries that are not followed by a sync point yet are
+  // requested to be flushed by the server, so their results don't wait for the next sync.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_receive_result(CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_compose<CompletionToken, void(error_code, result)>(
+      [this, coro = asio::coroutine{}](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        if (ec)
+          return self.complete(ec, {});
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if (num_pending_queries_ == 0)
+          {
+            BOOST_ASIO_CORO_YIELD asio::post(asio::append(std::move(self), error::no_pending_pipeline_result));
+          }
+
+          if (std::exchange(needs_flush_request_, false) && !PQsendFlushRequest(conn_.native_handle()))
+            return self.complete(error::pq_send_flush_request_failed, {});
+
+          BOOST_ASIO_CORO_YIELD conn_.async_flush(std::move(self));
+
+          // Skips the null results that terminate each query and the results of the sync points.
+          for (;;)
+          {
+            BOOST_ASIO_CORO_YIELD conn_.async_receive_result(std::move(self));
+
+            if (result && PQresultStatus(result.native_handle()) == PGRES_PIPELINE_SYNC)
+              num_pending_syncs_--;
+            else if (result)
+              break;
+          }
+
+          num_pending_queries_--;
+          conn_.notification_cs_->emit(asio::cancellation_type::terminal);
+          auto result_ec = conn_.result_status_to_error_code(result);
+          return self.complete(result_ec, std::move(result));
+        }
+      },
+      token,
+      conn_.socket_);
+  }
+
+  // Places a sync point after the last queries if needed, discards the results that haven't been received up to
+  // the last sync point and leaves pipeline mode. No queries can be pushed afterwards.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_close(CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_compose<CompletionToken, void(error_code)>(
+      [this, coro = asio::coroutine{}](auto& self, error_code ec = {}, result result = {}) mutable
+      {
+        if (ec)
+          return self.complete(ec);
+
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if (needs_sync_ && !PQpipelineSync(conn_.native_handle()))
+            return self.complete(error::pq_pipeline_sync_failed);
+
+          if (std::exchange(needs_sync_, false))
+            num_pending_syncs_++;
+
+          BOOST_ASIO_CORO_YIELD conn_.async_flush(std::move(self));
+
+          while (num_pending_syncs_ != 0)
+          {
+            BOOST_ASIO_CORO_YIELD conn_.async_receive_result(std::move(self));
+
+            if (result && PQresultStatus(result.native_handle()) == PGRES_PIPELINE_SYNC)
+              num_pending_syncs_--;
+            else if (result)
+              num_pending_queries_--;
+          }
+
+          if (!PQexitPipelineMode(conn_.native_handle()))
+            return self.complete(error::pq_exit_pipeline_mode_failed);
+
+          is_closed_ = true;
+          return self.complete({});
+        }
+      },
+      token,
+      conn_.socket_);
+  }
+
+  // A session must be ended with async_close unless the connection failed. As a last resort, the destructor leaves
+  // pipeline mode itself. That fails while results are outstanding, the connection is closed then, so later
+  // operations fail instead of waiting for results that never arrive.
+  ~basic_pipeline_session()
+  {
+    assert(
+      (is_closed_ || PQstatus(conn_.native_handle()) != CONNECTION_OK) &&
+      "pipeline_session destroyed without async_close");
+
+    if (!is_closed_ && !PQexitPipelineMode(conn_.native_handle()))
+      conn_.close();
+  }
+
+private:
+  // Resolving Oids needs a round trip of its own, which can't be interleaved with the queries of the session.
+  template<typename... Ts>
+  void verify_udts_of_params()
+  {
+    conn_.sync_oid_map();
+    detail::extract_new_udts_of_params<Ts...>(conn_.new_udts_, conn_.oid_map_);
+
+    if (conn_.new_udts_.empty())
+      return;
+
+    if (conn_.oid_cache_)
+      conn_.oid_cache_->lookup(conn_.new_udts_, conn_.oid_map_);
+
+    if (!conn_.new_udts_.empty())
+    {
+      conn_.new_udts_.clear();
+      throw boost::system::system_error{ error::user_defined_type_does_not_exist };
+    }
+  }
+
+  size_t on_pushed() noexcept
+  {
+    num_pending_queries_++;
+    needs_flush_request_ = true;
+    needs_sync_          = true;
+    return num_pushed_++;
+  }
+};
+
+using pipeline_session = basic_pipeline_session<>;
+} // namespace psql
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <psql/result.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace psql
+{
+// A statement prepared with async_prepare_statement, whose parameters have the types Ts. The Oids of the parameters
+// are fixed when it's prepared, and the description of its result is kept, so a row_mapper can be bound to it once
+// for all its executions. Copies share the same state, and it can only be executed on the connection that prepared
+// it.
+template<typename... Ts>
+class prepared_statement
+{
+  struct state
+  {
+    std::string name;
+    std::array<uint32_t, sizeof...(Ts)> param_oids;
+    result description;
+  };
+
+  std::shared_ptr<const state> state_;
+
+public:
+  prepared_statement() = default;
+
+  prepared_statement(std::string name, std::array<uint32_t, sizeof...(Ts)> param_oids, result description)
+    : state_{ std::make_shared<const state>(state{ std::move(name), param_oids, std::move(description) }) }
+  {
+  }
+
+  explicit operator bool() const noexcept
+  {
+    return state_ != nullptr;
+  }
+
+  const std::string& name() const noexcept
+  {
+    return state_->name;
+  }
+
+  std::span<const uint32_t, sizeof...(Ts)> param_oids() const noexcept
+  {
+    return state_->param_oids;
+  }
+
+  // A result without rows, which describes the fields of the results of the statement.
+  const result& description() const noexcept
+  {
+    return state_->description;
+  }
+};
+} // namespace psql
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <psql/array_view.hpp>
+#include <psql/composite_view.hpp>
+#include <psql/detail/deserialize_column.hpp>
 #include <psql/row.hpp>
 
 #include <memory>
@@ -70,6 +73,18 @@ public:
     return PQresultErrorMessage(pgresult_.get());
   }
 
+  // Decodes the leading fields of all rows into one vector per field. OIDs are verified once per field instead of
+  // once per value, string_views refer to the memory of the result.
+  template<typename... Ts>
+  std::tuple<std::vector<Ts>...> columns() const
+  {
+    auto result = std::tuple<std::vector<Ts>...>{};
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (detail::deserialize_column(pgresult_.get(), Is, std::get<Is>(result)), ...);
+    }(std::index_sequence_for<Ts...>{});
+    return result;
+  }
+
   [[nodiscard]] PGresult* release() noexcept
   {
     return pgresult_.release();
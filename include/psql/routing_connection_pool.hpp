@@ -0,0 +1,523 @@
+#pragma once
+
+#include <psql/connection_pool.hpp>
+
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace psql
+{
+enum class access_mode
+{
+  read_write,
+  read_only
+};
+
+struct routing_options
+{
+  // The hosts are probed this often for their role, round-trip time and replication lag.
+  std::chrono::steady_clock::duration health_check_interval = std::chrono::seconds{ 5 };
+  // Replicas lagging further behind aren't used for reads, zero disables the check.
+  std::chrono::steady_clock::duration max_replication_lag = std::chrono::steady_clock::duration::zero();
+  // How long a host is skipped after a connection to it failed, unless a probe succeeds earlier.
+  std::chrono::steady_clock::duration failure_backoff = std::chrono::seconds{ 5 };
+  // A probe that hasn't answered within this duration fails, zero disables the timeout.
+  std::chrono::steady_clock::duration probe_timeout = std::chrono::seconds{ 2 };
+};
+
+struct host_status
+{
+  std::optional<bool> is_primary; // unknown until the host has been probed successfully
+  bool is_available{};
+  std::chrono::steady_clock::duration latency{}; // smoothed round-trip time of the probes
+  std::chrono::steady_clock::duration replication_lag{};
+  size_t num_aquired{};
+};
+
+namespace detail
+{
+template<typename Executor>
+class basic_routing_connection_pool_impl
+  : public std::enable_shared_from_this<basic_routing_connection_pool_impl<Executor>>
+{
+  using error_code             = boost::system::error_code;
+  using clock_type             = std::chrono::steady_clock;
+  using pooled_connection_type = basic_pooled_connection<Executor>;
+  using strand_type            = asio::strand<Executor>;
+
+  // The probes of a host run on a dedicated connection, so they don't queue up behind the queries of the pool. Its
+  // members are only used on the strand.
+  struct probe_state
+  {
+    strand_type strand;
+    basic_connection<strand_type> conn{ strand };
+    asio::basic_waitable_timer<clock_type, asio::wait_traits<clock_type>, strand_type> timer{ strand };
+    asio::cancellation_signal cancel;
+    size_t id{}; // identifies the probe in flight, so a timer that fired late doesn't cancel the next one
+
+    explicit probe_state(const Executor& exec)
+      : strand{ exec }
+    {
+      // A probe that timed out is abandoned along with its connection, instead of waiting for the server.
+      conn.cancel_grace_period(clock_type::duration::zero());
+    }
+  };
+
+  struct host
+  {
+    basic_connection_pool<Executor> pool;
+    std::string conninfo;
+    std::unique_ptr<probe_state> probe;
+    std::optional<bool> is_primary;
+    clock_type::duration latency{};
+    clock_type::duration replication_lag{};
+    clock_type::time_point unavailable_until{};
+  };
+
+  struct host_waiter
+  {
+    access_mode mode;
+    asio::any_completion_handler<void(error_code)> handler;
+  };
+
+  // The lag is measured against the clock of the replica, so it grows while the primary has no writes to replay.
+  static constexpr auto probe_query =
+    "SELECT pg_is_in_recovery(), COALESCE(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()), 0)::FLOAT8";
+
+  std::mutex mtx_;
+  Executor exec_;
+  asio::steady_timer health_check_timer_;
+  routing_options options_;
+  std::vector<host> hosts_; // not resized after construction, the members of each host are guarded by mtx_
+  size_t num_pending_probes_{}; // of the refresh in flight
+  std::vector<asio::any_completion_handler<void(error_code)>> refresh_waiters_;
+  std::vector<host_waiter> host_waiters_;
+  bool is_probed_{}; // all the hosts have answered or failed their first probe
+
+public:
+  using executor_type = Executor;
+
+  basic_routing_connection_pool_impl(
+    Executor exec,
+    const std::vector<std::string>& conninfos,
+    size_t max_size_per_host,
+    routing_options options)
+    : exec_{ exec }
+    , health_check_timer_{ exec }
+    , options_{ options }
+    , is_probed_{ conninfos.empty() }
+  {
+    hosts_.reserve(conninfos.size());
+    for (const auto& conninfo : conninfos)
+      hosts_.push_back(
+        { basic_connection_pool<Executor>{ exec, conninfo, max_size_per_host },
+          conninfo,
+          std::make_unique<probe_state>(exec) });
+  }
+
+  const executor_type& get_executor() noexcept
+  {
+    return exec_;
+  }
+
+  size_t num_hosts() const noexcept
+  {
+    return hosts_.size();
+  }
+
+  basic_connection_pool<Executor>& host_pool(size_t index) noexcept
+  {
+    return hosts_[index].pool;
+  }
+
+  host_status status(size_t index)
+  {
+    auto lg  = std::lock_guard<std::mutex>{ mtx_ };
+    auto& h  = hosts_[index];
+    auto now = clock_type::now();
+    return {
+      h.is_primary, h.is_primary.has_value() && h.unavailable_until <= now, h.latency, h.replication_lag,
+      h.pool.num_aquired()
+    };
+  }
+
+  // Probes the hosts now, and periodically from then on.
+  void start_health_checks()
+  {
+    if (hosts_.empty())
+      return;
+
+    refresh(asio::bind_executor(
+      exec_,
+      [wp = this->weak_from_this()](error_code)
+      {
+        if (auto sp = wp.lock())
+          sp->schedule_health_check();
+      }));
+  }
+
+  // Probes all the hosts in parallel, completes once each of them has answered or failed. A refresh that is already
+  // in flight is shared instead of starting another one.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_refresh(CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_initiate<CompletionToken, void(error_code)>(
+      [this](auto handler) { refresh(std::move(handler)); }, token);
+  }
+
+  // Takes a connection from the primary for read_write, or from the replica with the lowest round-trip time
+  // weighted by its aquired connections for read_only. Reads go to the primary when no replica is available. A host
+  // whose connection fails is skipped for failure_backoff and the next best one is tried. Until the first probes of
+  // all the hosts are done, it only waits for a host of the requested mode to answer.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_aquire(access_mode mode, CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_compose<CompletionToken, void(error_code, pooled_connection_type)>(
+      [this, mode, coro = asio::coroutine{}, attempts = size_t{}, index = size_t{}, last_ec = error_code{}](
+        auto& self, error_code ec = {}, std::optional<pooled_connection_type> aquired = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          BOOST_ASIO_CORO_YIELD async_wait_for_host(mode, std::move(self));
+
+          for (; attempts < hosts_.size(); attempts++)
+          {
+            if (auto selected = select_host(mode))
+              index = *selected;
+            else
+              break;
+
+            BOOST_ASIO_CORO_YIELD hosts_[index].pool.async_aquire(std::move(self));
+
+            if (!ec)
+              return self.complete({}, std::move(*aquired));
+
+            if (ec == asio::error::operation_aborted || !!self.cancelled())
+              return self.complete(ec, pooled_connection_type{ exec_ });
+
+            last_ec = ec;
+            mark_unavailable(index);
+          }
+
+          if (!last_ec)
+            last_ec = error::no_host_available;
+
+          return self.complete(last_ec, pooled_connection_type{ exec_ });
+        }
+      },
+      token,
+      exec_);
+  }
+
+private:
+  // Completes once a host of the given mode has answered its probe, or all the hosts have been probed once.
+  template<typename CompletionToken>
+  auto async_wait_for_host(access_mode mode, CompletionToken&& token)
+  {
+    return asio::async_initiate<CompletionToken, void(error_code)>(
+      [this, mode](auto handler)
+      {
+        auto lg = std::unique_lock<std::mutex>{ mtx_ };
+        if (!is_host_ready_locked(mode))
+          return host_waiters_.push_back({ mode, std::move(handler) });
+
+        lg.unlock();
+        asio::post(asio::append(std::move(handler), error_code{}));
+      },
+      token);
+  }
+
+  // Must be called with mtx_ held.
+  bool is_host_ready_locked(access_mode mode)
+  {
+    return is_probed_ || select_host_locked(mode).has_value();
+  }
+
+  std::optional<size_t> select_host(access_mode mode)
+  {
+    auto lg       = std::lock_guard<std::mutex>{ mtx_ };
+    auto selected = select_host_locked(mode);
+    if (!selected && mode == access_mode::read_only)
+      selected = select_host_locked(access_mode::read_write);
+    return selected;
+  }
+
+  // Must be called with mtx_ held.
+  std::optional<size_t> select_host_locked(access_mode mode)
+  {
+    auto now  = clock_type::now();
+    auto best = std::optional<size_t>{};
+    auto cost = clock_type::rep{};
+
+    for (size_t i = 0; i < hosts_.size(); i++)
+    {
+      const auto& h = hosts_[i];
+      if (!h.is_primary || h.unavailable_until > now || *h.is_primary != (mode == access_mode::read_write))
+        continue;
+
+      if (mode == access_mode::read_only && options_.max_replication_lag > clock_type::duration::zero() &&
+          h.replication_lag > options_.max_replication_lag)
+        continue;
+
+      // Each aquired connection is taken for a query in flight, which queues up behind the others on the server.
+      auto c = (h.latency.count() + 1) * static_cast<clock_type::rep>(h.pool.num_aquired() + 1);
+      if (!best || c < cost)
+      {
+        best = i;
+        cost = c;
+      }
+    }
+
+    return best;
+  }
+
+  void mark_unavailable(size_t index)
+  {
+    auto lg                         = std::lock_guard<std::mutex>{ mtx_ };
+    hosts_[index].unavailable_until = clock_type::now() + options_.failure_backoff;
+  }
+
+  void refresh(asio::any_completion_handler<void(error_code)> handler)
+  {
+    if (hosts_.empty())
+      return asio::post(asio::append(std::move(handler), error_code{}));
+
+    {
+      auto lg = std::lock_guard<std::mutex>{ mtx_ };
+      refresh_waiters_.push_back(std::move(handler));
+
+      if (num_pending_probes_ != 0)
+        return;
+
+      num_pending_probes_ = hosts_.size();
+    }
+
+    for (size_t i = 0; i < hosts_.size(); i++)
+      asio::dispatch(hosts_[i].probe->strand, [sp = this->shared_from_this(), i] { sp->probe(i); });
+  }
+
+  // Must be called on the strand of the probe.
+  void probe(size_t index)
+  {
+    auto& p = *hosts_[index].probe;
+    auto id = ++p.id;
+
+    if (options_.probe_timeout > clock_type::duration::zero())
+    {
+      p.timer.expires_after(options_.probe_timeout);
+      p.timer.async_wait(
+        [&p, id](error_code ec)
+        {
+          if (!ec && id == p.id)
+            p.cancel.emit(asio::cancellation_type::terminal);
+        });
+    }
+
+    async_probe(
+      p,
+      hosts_[index].conninfo,
+      asio::bind_cancellation_slot(
+        p.cancel.slot(),
+        [this, sp = this->shared_from_this(), index, &p](error_code ec, clock_type::duration rtt, result res)
+        {
+          p.id++;
+          p.timer.cancel();
+
+          if (ec)
+          {
+            // The connection is opened again by the next probe.
+            p.conn.close();
+            return on_probed(index, ec, {}, {});
+          }
+
+          const auto [is_in_recovery, lag] = as<bool, double>(res);
+          const auto replication_lag =
+            std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>{ lag });
+          on_probed(index, {}, rtt, std::pair{ !is_in_recovery, replication_lag });
+        }));
+  }
+
+  template<typename CompletionToken>
+  auto async_probe(probe_state& p, const std::string& conninfo, CompletionToken&& token)
+  {
+    return asio::async_compose<CompletionToken, void(error_code, clock_type::duration, result)>(
+      [&p, &conninfo, coro = asio::coroutine{}, start = clock_type::time_point{}](
+        auto& self, error_code ec = {}, result res = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if (PQstatus(p.conn.native_handle()) != CONNECTION_OK)
+          {
+            BOOST_ASIO_CORO_YIELD p.conn.async_connect(conninfo, std::move(self));
+            if (ec)
+              return self.complete(ec, {}, {});
+          }
+
+          start = clock_type::now();
+          BOOST_ASIO_CORO_YIELD p.conn.async_query(probe_query, std::move(self));
+          return self.complete(ec, clock_type::now() - start, std::move(res));
+        }
+      },
+      token,
+      p.strand);
+  }
+
+  void on_probed(
+    size_t index,
+    error_code ec,
+    clock_type::duration rtt,
+    std::optional<std::pair<bool, clock_type::duration>> role)
+  {
+    auto ready     = std::vector<asio::any_completion_handler<void(error_code)>>{};
+    auto refreshed = std::vector<asio::any_completion_handler<void(error_code)>>{};
+
+    {
+      auto lg = std::lock_guard<std::mutex>{ mtx_ };
+      auto& h = hosts_[index];
+
+      if (ec || !role)
+      {
+        h.unavailable_until = clock_type::now() + options_.failure_backoff;
+      }
+      else
+      {
+        // The round-trip time is smoothed over the last few probes, so a single slow one doesn't move reads away.
+        h.latency           = h.is_primary ? (h.latency * 7 + rtt) / 8 : rtt;
+        h.is_primary        = role->first;
+        h.replication_lag   = role->first ? clock_type::duration::zero() : role->second;
+        h.unavailable_until = {};
+      }
+
+      // The last probe of a refresh completes it.
+      if (--num_pending_probes_ == 0)
+      {
+        is_probed_ = true;
+        refreshed  = std::move(refresh_waiters_);
+        refresh_waiters_.clear();
+      }
+
+      // The aquisitions can go on as soon as a host of their mode has answered, instead of waiting for all of them.
+      for (auto& w : host_waiters_)
+        if (is_host_ready_locked(w.mode))
+          ready.push_back(std::move(w.handler));
+      std::erase_if(host_waiters_, [](const host_waiter& w) { return !w.handler; });
+    }
+
+    for (auto& handler : ready)
+      asio::post(asio::append(std::move(handler), error_code{}));
+
+    for (auto& handler : refreshed)
+      asio::post(asio::append(std::move(handler), error_code{}));
+  }
+
+  void schedule_health_check()
+  {
+    if (options_.health_check_interval <= clock_type::duration::zero())
+      return;
+
+    health_check_timer_.expires_after(options_.health_check_interval);
+    health_check_timer_.async_wait(
+      [wp = this->weak_from_this()](error_code ec)
+      {
+        auto sp = wp.lock();
+        if (!sp || ec)
+          return;
+
+        sp->refresh(asio::bind_executor(
+          sp->exec_,
+          [wp](error_code)
+          {
+            if (auto sp = wp.lock())
+              sp->schedule_health_check();
+          }));
+      });
+  }
+};
+} // namespace detail
+
+// Routes aquisitions over the connection pools of a primary and its replicas: writes go to the primary and reads to
+// the closest and least loaded replica. The roles of the hosts are discovered by probing them, so a promoted replica
+// takes over writes after the next health check.
+template<typename Executor = asio::any_io_executor>
+class basic_routing_connection_pool
+{
+  using impl_type = detail::basic_routing_connection_pool_impl<Executor>;
+  std::shared_ptr<impl_type> impl_;
+
+public:
+  using executor_type = Executor;
+
+  // Each connection string is given its own pool of up to max_size_per_host connections.
+  basic_routing_connection_pool(
+    Executor exec,
+    const std::vector<std::string>& conninfos,
+    size_t max_size_per_host = 32,
+    routing_options options  = {})
+    : impl_{ std::make_shared<impl_type>(std::move(exec), conninfos, max_size_per_host, options) }
+  {
+    impl_->start_health_checks();
+  }
+
+  template<typename ExecutionContext>
+  basic_routing_connection_pool(
+    ExecutionContext& context,
+    const std::vector<std::string>& conninfos,
+    size_t max_size_per_host = 32,
+    routing_options options  = {})
+    : impl_{ std::make_shared<impl_type>(context.get_executor(), conninfos, max_size_per_host, options) }
+  {
+    impl_->start_health_checks();
+  }
+
+  template<typename OtherExecutor>
+  struct rebind_executor
+  {
+    using other = basic_routing_connection_pool<OtherExecutor>;
+  };
+
+  executor_type get_executor() const noexcept
+  {
+    return impl_->get_executor();
+  }
+
+  size_t num_hosts() const noexcept
+  {
+    return impl_->num_hosts();
+  }
+
+  // The pool of the host at the given index of the connection strings, for configuring it.
+  basic_connection_pool<Executor>& host_pool(size_t index) noexcept
+  {
+    return impl_->host_pool(index);
+  }
+
+  host_status status(size_t index) const
+  {
+    return impl_->status(index);
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_aquire(access_mode mode, CompletionToken&& token = CompletionToken{})
+  {
+    return impl_->async_aquire(mode, std::forward<CompletionToken>(token));
+  }
+
+  // Probes all the hosts now instead of waiting for the next health check.
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_refresh(CompletionToken&& token = CompletionToken{})
+  {
+    return impl_->async_refresh(std::forward<CompletionToken>(token));
+  }
+};
+
+using routing_connection_pool = basic_routing_connection_pool<>;
+} // namespace psql
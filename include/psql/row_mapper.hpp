@@ -0,0 +1,247 @@
+#pragma once
+
+#include <psql/error.hpp>
+#include <psql/result.hpp>
+
+#include <boost/pfr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace psql
+{
+// Maps the rows of a result to an aggregate, one field per member. Fields are resolved and their types are checked
+// once when the mapper is bound to a result, rows are decoded afterwards without further lookups or checks. The
+// member types of composite and array fields are checked on the first value of the bound result that contains them
+// all; fields without such a value, e.g. when binding to the description of a prepared statement, are checked in
+// every row instead.
+template<typename T>
+class row_mapper
+{
+  static constexpr std::size_t num_members = boost::pfr::tuple_size_v<T>;
+
+  std::array<int, num_members> indices_{};
+  std::array<bool, num_members> is_verified_{}; // whether the nested types of a field are known to match
+
+public:
+  using column_names_type = std::array<std::string_view, num_members>;
+
+  row_mapper() = default;
+
+  // Binds the members to the leading fields, in order.
+  boost::system::error_code bind(const result& result)
+  {
+    for (std::size_t i = 0; i < num_members; i++)
+      indices_[i] = static_cast<int>(i);
+
+    return verify(result);
+  }
+
+  // Binds each member to the field with the corresponding name, names are matched the same way as PQfnumber does.
+  boost::system::error_code bind(const result& result, const column_names_type& column_names)
+  {
+    for (std::size_t i = 0; i < num_members; i++)
+    {
+      indices_[i] = PQfnumber(result.native_handle(), std::string{ column_names[i] }.c_str());
+      if (indices_[i] == -1)
+        return error::field_does_not_exist;
+    }
+
+    return verify(result);
+  }
+
+#if BOOST_PFR_CORE_NAME_ENABLED
+  // Binds each member to the field with the same name as the member.
+  boost::system::error_code bind_by_name(const result& result)
+  {
+    return bind(result, boost::pfr::names_as_array<T>());
+  }
+#endif
+
+  // The row must belong to the result the mapper is bound to, or to one with the same columns.
+  T operator()(const row& row) const
+  {
+    auto value = T{};
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (deserialize_field(row[indices_[Is]], is_verified_[Is], boost::pfr::get<Is>(value)), ...);
+    }(std::make_index_sequence<num_members>{});
+    return value;
+  }
+
+  std::vector<T> map_all(const result& result) const
+  {
+    auto values = std::vector<T>{};
+    values.reserve(result.size());
+    for (const auto row : result)
+      values.push_back((*this)(row));
+    return values;
+  }
+
+private:
+  template<typename U>
+  static void deserialize_field(const field& field, bool is_verified, U& value)
+  {
+    if (is_verified)
+      detail::deserialize_unchecked({ field.data(), field.size() }, value);
+    else
+      detail::deserialize({ field.data(), field.size() }, value);
+  }
+
+  boost::system::error_code verify(const result& result)
+  {
+    is_verified_ = {};
+    auto ec      = boost::system::error_code{};
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      ((ec = verify_field<boost::pfr::tuple_element_t<Is, T>>(result, indices_[Is], is_verified_[Is])) || ...);
+    }(std::make_index_sequence<num_members>{});
+    return ec;
+  }
+
+  template<typename U>
+  static boost::system::error_code verify_field(const result& result, int index, bool& is_verified)
+  {
+    if (index >= PQnfields(result.native_handle()))
+      return error::field_does_not_exist;
+
+    const auto expected_oid = detail::oid_of<U>();
+    if (expected_oid != 0 && expected_oid != PQftype(result.native_handle(), index))
+      return error::mismatched_field_type;
+
+    // Nested types are the same in all rows, the first value that contains all of them is enough.
+    if constexpr (detail::is_composite_v<U> || detail::is_array_v<U>)
+    {
+      for (const auto row : result)
+      {
+        if (row[index].is_null())
+          continue;
+
+        auto ec = boost::system::error_code{};
+        if (verify_value<U>({ row[index].data(), row[index].size() }, ec) || ec)
+        {
+          is_verified = !ec;
+          return ec;
+        }
+      }
+    }
+
+    return {};
+  }
+
+  template<typename U>
+  static constexpr std::size_t member_count() noexcept
+  {
+    if constexpr (detail::is_tuple_v<U>)
+      return std::tuple_size_v<U>;
+    else
+      return boost::pfr::tuple_size_v<U>;
+  }
+
+  template<typename U, std::size_t I>
+  static auto member_tag() noexcept
+  {
+    if constexpr (detail::is_tuple_v<U>)
+      return std::type_identity<std::tuple_element_t<I, U>>{};
+    else
+      return std::type_identity<boost::pfr::tuple_element_t<I, U>>{};
+  }
+
+  template<typename U>
+  static constexpr bool has_nested_types_v = detail::is_composite_v<U> || detail::is_array_v<U>;
+
+  // Checks the Oids and member counts nested in a composite or array value. Returns false if the value doesn't
+  // contain all the nested types, because of null members or empty arrays, so another value has to be checked.
+  template<typename U>
+  static bool verify_value(std::span<const char> buffer, boost::system::error_code& ec)
+  {
+    if constexpr (detail::is_composite_v<U>)
+    {
+      auto count = int32_t{};
+      detail::deserialize<int32_t>(buffer, count);
+      if (static_cast<std::size_t>(count) != member_count<U>())
+      {
+        ec = error::mismatched_composite_member_count;
+        return true;
+      }
+
+      buffer           = buffer.subspan(4);
+      auto is_complete = true;
+      [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+        ((is_complete &= verify_member<typename decltype(member_tag<U, Is>())::type>(buffer, ec), !ec) && ...);
+      }(std::make_index_sequence<member_count<U>()>{});
+      return is_complete || ec;
+    }
+    else if constexpr (detail::is_array_v<U>)
+    {
+      using value_type = std::decay_t<typename U::value_type>;
+
+      auto oid = uint32_t{};
+      detail::deserialize<uint32_t>(buffer.subspan(8), oid);
+      if (const auto expected_oid = detail::oid_of<value_type>(); expected_oid != 0 && expected_oid != oid)
+      {
+        ec = error::mismatched_field_type;
+        return true;
+      }
+
+      if constexpr (has_nested_types_v<value_type>)
+      {
+        auto dimensions_count = int32_t{};
+        detail::deserialize<int32_t>(buffer, dimensions_count);
+        if (dimensions_count != 1)
+          return false;
+
+        auto size = int32_t{};
+        detail::deserialize<int32_t>(buffer.subspan(12), size);
+
+        buffer = buffer.subspan(20);
+        for (int32_t i = 0; i < size; i++)
+        {
+          auto value_size = int32_t{};
+          detail::deserialize<int32_t>(buffer, value_size);
+          if (value_size != -1 && verify_value<value_type>(buffer.subspan(4, value_size), ec))
+            return true;
+          if (ec)
+            return true;
+          buffer = buffer.subspan(4 + std::max(value_size, 0));
+        }
+        return false;
+      }
+      return true;
+    }
+    else
+    {
+      return true;
+    }
+  }
+
+  // Consumes a member of a composite value.
+  template<typename M>
+  static bool verify_member(std::span<const char>& buffer, boost::system::error_code& ec)
+  {
+    auto oid = uint32_t{};
+    detail::deserialize<uint32_t>(buffer, oid);
+    if (const auto expected_oid = detail::oid_of<M>(); expected_oid != 0 && expected_oid != oid)
+    {
+      ec = error::mismatched_field_type;
+      return true;
+    }
+
+    auto member_size = int32_t{};
+    detail::deserialize<int32_t>(buffer.subspan(4), member_size);
+
+    auto is_complete = !has_nested_types_v<M>;
+    if (member_size != -1)
+    {
+      is_complete = verify_value<M>(buffer.subspan(8, member_size), ec);
+      buffer      = buffer.subspan(8 + member_size);
+    }
+    else
+    {
+      buffer = buffer.subspan(8);
+    }
+    return is_complete;
+  }
+};
+} // namespace psql
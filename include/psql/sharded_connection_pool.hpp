@@ -0,0 +1,467 @@
+#pragma once
+
+#include <psql/connection_pool.hpp>
+
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <boost/intrusive/list.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace psql
+{
+namespace detail
+{
+// A connection pool whose idle connections are split into shards selected by the calling thread. Acquires and
+// returns on a thread only touch its own shard's lock, and an empty shard steals from the others. Callers that
+// have to wait are queued in a single FIFO, so wakeups are fair and don't depend on the shard they came from.
+//
+// Shards are keyed by thread rather than by the executor of the acquiring handler: the executors of an io_context
+// all compare equal and have no identity to hash, so a thread is the finest unit of locality there is. The pool
+// therefore assumes each thread acquires and returns its own connections, e.g. one io_context run by many threads
+// or one io_context per thread. Handlers of a strand that hop between threads still work, but spread their
+// connections over several shards.
+//
+// A shard lock is only contended by a steal, which skips locked shards, so it is uncontended on the fast path. The
+// waiters' lock is only taken once the pool is exhausted and callers have to queue anyway.
+//
+// The Oid cache is shared by all the connections, as in basic_connection_pool. Keeping a minimum of idle
+// connections, idle_timeout and max_lifetime are out of scope: there is no reaper walking the shards, closed and
+// broken connections are dropped on return, and connections otherwise live as long as the pool.
+template<typename Executor>
+class basic_sharded_connection_pool_impl
+  : public std::enable_shared_from_this<basic_sharded_connection_pool_impl<Executor>>
+{
+  using error_code             = boost::system::error_code;
+  using connection_type        = basic_connection<Executor>;
+  using pooled_connection_type = basic_pooled_connection<Executor, basic_sharded_connection_pool_impl>;
+
+  struct waiter : boost::intrusive::list_base_hook<>
+  {
+    asio::any_completion_handler<void(error_code)> handler;
+    std::optional<connection_type> conn; // empty if the waiter is handed a slot for opening a new connection
+  };
+
+  struct alignas(64) shard
+  {
+    std::mutex mtx;
+    std::vector<connection_type> idle_conns; // most recently returned last
+  };
+
+  Executor exec_;
+  std::string conninfo_;
+  std::atomic<size_t> max_size_{};
+  std::atomic<size_t> aquired_conns_{};
+  std::atomic<size_t> statement_cache_capacity_{};
+  std::atomic<std::chrono::steady_clock::duration> connect_attempt_delay_{};
+  std::unique_ptr<shard[]> shards_;
+  size_t num_shards_{};
+  std::mutex waiters_mtx_;
+  boost::intrusive::list<waiter> waiters_;
+  std::atomic<size_t> num_waiters_{};
+  const std::shared_ptr<oid_cache> oid_cache_ = std::make_shared<oid_cache>();
+
+public:
+  using executor_type = Executor;
+
+  basic_sharded_connection_pool_impl(Executor exec, std::string conninfo, size_t max_size, size_t num_shards)
+    : exec_{ std::move(exec) }
+    , conninfo_{ std::move(conninfo) }
+    , max_size_{ max_size }
+    , shards_{ std::make_unique<shard[]>(std::max<size_t>(num_shards, 1)) }
+    , num_shards_{ std::max<size_t>(num_shards, 1) }
+  {
+  }
+
+  const executor_type& get_executor() noexcept
+  {
+    return exec_;
+  }
+
+  size_t max_size() noexcept
+  {
+    return max_size_.load();
+  }
+
+  void max_size(size_t value) noexcept
+  {
+    max_size_.store(value);
+    while (num_waiters_.load() != 0 && try_reserve_slot())
+    {
+      if (!try_hand_over_slot())
+      {
+        aquired_conns_--;
+        break;
+      }
+    }
+  }
+
+  size_t num_aquired() noexcept
+  {
+    return aquired_conns_.load();
+  }
+
+  size_t num_shards() const noexcept
+  {
+    return num_shards_;
+  }
+
+  size_t statement_cache_capacity() noexcept
+  {
+    return statement_cache_capacity_.load(std::memory_order_relaxed);
+  }
+
+  void statement_cache_capacity(size_t value) noexcept
+  {
+    statement_cache_capacity_.store(value, std::memory_order_relaxed);
+  }
+
+  const std::shared_ptr<oid_cache>& shared_oid_cache() const noexcept
+  {
+    return oid_cache_;
+  }
+
+  std::chrono::steady_clock::duration connect_attempt_delay() noexcept
+  {
+    return connect_attempt_delay_.load(std::memory_order_relaxed);
+  }
+
+  void connect_attempt_delay(std::chrono::steady_clock::duration value) noexcept
+  {
+    connect_attempt_delay_.store(value, std::memory_order_relaxed);
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_aquire(CompletionToken&& token = CompletionToken{})
+  {
+    return asio::async_compose<CompletionToken, void(error_code, pooled_connection_type)>(
+      [this, coro = asio::coroutine{}, conn = std::optional<connection_type>{}, w = std::unique_ptr<waiter>{}](
+        auto& self, error_code ec = {}) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          if ((conn = try_take_idle(false)))
+          {
+            aquired_conns_++;
+            BOOST_ASIO_CORO_YIELD asio::post(std::move(self));
+          }
+          else if (!try_reserve_slot())
+          {
+            w = std::make_unique<waiter>();
+            BOOST_ASIO_CORO_YIELD async_wait_for_connection(*w, std::move(self));
+            self.get_cancellation_state().slot().clear();
+
+            if (ec)
+              return self.complete(ec, { {}, connection_type{ exec_ } });
+
+            conn = std::move(w->conn);
+          }
+
+          // Either a free slot was reserved or one was handed over by a waker.
+          if (!conn)
+          {
+            conn.emplace(exec_);
+            conn->statement_cache_capacity(statement_cache_capacity());
+            conn->shared_oid_cache(oid_cache_);
+
+            if (connect_attempt_delay() == std::chrono::steady_clock::duration::zero())
+            {
+              BOOST_ASIO_CORO_YIELD conn->async_connect(conninfo_, std::move(self));
+            }
+            else
+            {
+              BOOST_ASIO_CORO_YIELD conn->async_connect_resolved(conninfo_, connect_attempt_delay(), std::move(self));
+            }
+
+            if (ec)
+            {
+              release_slot();
+              return self.complete(ec, { {}, std::move(*conn) });
+            }
+          }
+
+          return self.complete({}, { this->weak_from_this(), std::move(*conn) });
+        }
+      },
+      token,
+      exec_);
+  }
+
+  // Connection lifetimes are not tracked by the sharded pool, see above.
+  void return_connection(connection_type&& conn, std::chrono::steady_clock::time_point)
+  {
+    if (PQstatus(conn.native_handle()) != CONNECTION_OK || PQtransactionStatus(conn.native_handle()) != PQTRANS_IDLE)
+      return release_slot();
+
+    auto rest = try_hand_over(std::move(conn));
+    if (!rest)
+      return;
+
+    aquired_conns_--;
+    push_idle(std::move(*rest));
+
+    // A waiter might have been queued after the check above, but before the connection became idle.
+    if (num_waiters_.load() != 0)
+      serve_waiter_from_idle();
+  }
+
+private:
+  shard& local_shard() noexcept
+  {
+    thread_local const auto hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return shards_[hash % num_shards_];
+  }
+
+  void push_idle(connection_type&& conn)
+  {
+    auto& s = local_shard();
+    auto lg = std::lock_guard<std::mutex>{ s.mtx };
+    s.idle_conns.push_back(std::move(conn));
+  }
+
+  // Takes the most recently returned connection of the local shard, or steals one from the other shards. Contended
+  // shards are skipped unless `wait` is set; their lock holders re-check the waiters after pushing a connection.
+  std::optional<connection_type> try_take_idle(bool wait)
+  {
+    auto& local = local_shard();
+    auto first  = static_cast<size_t>(&local - shards_.get());
+
+    for (size_t i = 0; i < num_shards_; i++)
+    {
+      auto& s  = shards_[(first + i) % num_shards_];
+      auto lck = std::unique_lock<std::mutex>{ s.mtx, std::defer_lock };
+
+      if (wait || &s == &local)
+        lck.lock();
+      else if (!lck.try_lock())
+        continue;
+
+      if (!s.idle_conns.empty())
+      {
+        auto conn = std::move(s.idle_conns.back());
+        s.idle_conns.pop_back();
+        return conn;
+      }
+    }
+    return std::nullopt;
+  }
+
+  bool try_reserve_slot() noexcept
+  {
+    auto n = aquired_conns_.load();
+    while (n < max_size_.load())
+    {
+      if (aquired_conns_.compare_exchange_weak(n, n + 1))
+        return true;
+    }
+    return false;
+  }
+
+  // Gives up an aquired slot, or passes it on to the oldest waiter.
+  void release_slot()
+  {
+    if (try_hand_over_slot())
+      return;
+
+    aquired_conns_--;
+
+    if (num_waiters_.load() != 0 && try_reserve_slot() && !try_hand_over_slot())
+      aquired_conns_--;
+  }
+
+  waiter* try_pop_waiter()
+  {
+    if (num_waiters_.load() == 0)
+      return nullptr;
+
+    auto lg = std::lock_guard<std::mutex>{ waiters_mtx_ };
+    if (waiters_.empty())
+      return nullptr;
+
+    auto* w = &waiters_.front();
+    waiters_.pop_front();
+    num_waiters_--;
+    return w;
+  }
+
+  // Hands the connection to the oldest waiter, gives it back if there is none.
+  std::optional<connection_type> try_hand_over(connection_type&& conn)
+  {
+    auto* w = try_pop_waiter();
+    if (!w)
+      return std::move(conn);
+
+    w->conn.emplace(std::move(conn));
+    asio::post(asio::append(std::move(w->handler), error_code{}));
+    return std::nullopt;
+  }
+
+  bool try_hand_over_slot()
+  {
+    auto* w = try_pop_waiter();
+    if (!w)
+      return false;
+
+    asio::post(asio::append(std::move(w->handler), error_code{}));
+    return true;
+  }
+
+  void serve_waiter_from_idle()
+  {
+    if (auto conn = try_take_idle(true))
+    {
+      aquired_conns_++;
+      if (auto rest = try_hand_over(std::move(*conn)))
+      {
+        aquired_conns_--;
+        push_idle(std::move(*rest));
+      }
+    }
+  }
+
+  void cancel_waiter(waiter& w)
+  {
+    {
+      auto lg = std::lock_guard<std::mutex>{ waiters_mtx_ };
+      if (!w.is_linked())
+        return;
+      waiters_.erase(waiters_.iterator_to(w));
+      num_waiters_--;
+    }
+    asio::post(asio::append(std::move(w.handler), error_code{ asio::error::operation_aborted }));
+  }
+
+  template<typename CompletionToken>
+  auto async_wait_for_connection(waiter& w, CompletionToken&& token)
+  {
+    return asio::async_initiate<CompletionToken, void(error_code)>(
+      [this](auto handler, waiter* w)
+      {
+        if (auto slot = asio::get_associated_cancellation_slot(handler); slot.is_connected())
+          slot.assign([this, w](asio::cancellation_type) { cancel_waiter(*w); });
+
+        {
+          auto lg    = std::lock_guard<std::mutex>{ waiters_mtx_ };
+          w->handler = std::move(handler);
+          waiters_.push_back(*w);
+          num_waiters_++;
+        }
+
+        // The waiter must not be touched from here on, it may have been completed already. Connections and slots
+        // released before it was queued are handed to the oldest waiter, which keeps the queue fair.
+        if (num_waiters_.load() != 0)
+          serve_waiter_from_idle();
+        if (num_waiters_.load() != 0 && try_reserve_slot() && !try_hand_over_slot())
+          aquired_conns_--;
+      },
+      token,
+      &w);
+  }
+};
+} // namespace detail
+
+template<typename Executor = asio::any_io_executor>
+class basic_sharded_connection_pool
+{
+  using impl_type = detail::basic_sharded_connection_pool_impl<Executor>;
+  std::shared_ptr<impl_type> impl_;
+
+public:
+  using executor_type = Executor;
+
+  // Uses one shard per hardware thread by default.
+  basic_sharded_connection_pool(
+    Executor exec,
+    std::string conninfo,
+    size_t max_size   = 32,
+    size_t num_shards = std::thread::hardware_concurrency())
+    : impl_{ std::make_shared<impl_type>(std::move(exec), std::move(conninfo), max_size, num_shards) }
+  {
+  }
+
+  template<typename ExecutionContext>
+  basic_sharded_connection_pool(
+    ExecutionContext& context,
+    std::string conninfo,
+    size_t max_size   = 32,
+    size_t num_shards = std::thread::hardware_concurrency())
+    : impl_{ std::make_shared<impl_type>(context.get_executor(), std::move(conninfo), max_size, num_shards) }
+  {
+  }
+
+  template<typename OtherExecutor>
+  struct rebind_executor
+  {
+    using other = basic_sharded_connection_pool<OtherExecutor>;
+  };
+
+  executor_type get_executor() const noexcept
+  {
+    return impl_->get_executor();
+  }
+
+  size_t max_size() const noexcept
+  {
+    return impl_->max_size();
+  }
+
+  void max_size(size_t value) noexcept
+  {
+    impl_->max_size(value);
+  }
+
+  size_t num_aquired() const noexcept
+  {
+    return impl_->num_aquired();
+  }
+
+  size_t num_shards() const noexcept
+  {
+    return impl_->num_shards();
+  }
+
+  size_t statement_cache_capacity() const noexcept
+  {
+    return impl_->statement_cache_capacity();
+  }
+
+  void statement_cache_capacity(size_t value) noexcept
+  {
+    impl_->statement_cache_capacity(value);
+  }
+
+  // The Oids of user-defined types are resolved once for the whole pool, and forgotten when a query fails in a way
+  // that suggests they are stale.
+  const std::shared_ptr<oid_cache>& shared_oid_cache() const noexcept
+  {
+    return impl_->shared_oid_cache();
+  }
+
+  std::chrono::steady_clock::duration connect_attempt_delay() const noexcept
+  {
+    return impl_->connect_attempt_delay();
+  }
+
+  // Opens the connections from now on with async_connect_resolved and the given attempt delay, so the hosts are
+  // resolved without blocking the executor. Zero, the default, opens them with async_connect.
+  void connect_attempt_delay(std::chrono::steady_clock::duration value) noexcept
+  {
+    impl_->connect_attempt_delay(value);
+  }
+
+  template<typename CompletionToken = asio::default_completion_token_t<executor_type>>
+  auto async_aquire(CompletionToken&& token = CompletionToken{})
+  {
+    return impl_->async_aquire(std::forward<CompletionToken>(token));
+  }
+};
+
+using sharded_connection_pool = basic_sharded_connection_pool<>;
+using sharded_pooled_connection =
+  basic_pooled_connection<asio::any_io_executor, detail::basic_sharded_connection_pool_impl<asio::any_io_executor>>;
+} // namespace psql
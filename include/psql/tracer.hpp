@@ -0,0 +1,54 @@
+#pragma once
+
+#include <boost/system/error_code.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace psql
+{
+// The phases of a query, each one ends at the given point in time and the next one starts there. A phase that didn't
+// take place, e.g. resolving the Oids when they are all known, ends where it starts.
+struct query_trace
+{
+  using time_point = std::chrono::steady_clock::time_point;
+
+  std::string_view query; // the query text, or the name of the prepared statement
+  time_point start;
+  time_point udts_resolved; // the Oids of the user-defined types in the parameters are known
+  time_point serialized;    // the parameters are serialized and the query is queued in libpq
+  time_point sent;          // the query is flushed to the socket
+  time_point first_byte;    // the first data of the response is read from the socket
+  time_point last_byte;     // the response is complete
+  time_point decoded;       // libpq has built the result from the response
+  time_point completed;
+  std::uint64_t bytes_sent{};     // the parameters, and the query text unless prepared
+  std::uint64_t bytes_received{}; // memory of the result
+  std::uint64_t num_rows{};
+  boost::system::error_code ec;
+};
+
+// Receives the traces of async_query and async_query_prepared operations, right before they complete. With
+// auto-pipelining, the send and receive phases are those of the pipeline the query was part of. Nothing is traced
+// while a connection has no tracer, and on_query must not throw.
+class query_tracer
+{
+public:
+  virtual ~query_tracer() = default;
+
+  virtual void on_query(const query_trace& trace) = 0;
+};
+
+namespace detail
+{
+// The times of the last exchange with the server, they're only taken while a tracer is set.
+struct exchange_times
+{
+  std::chrono::steady_clock::time_point sent;
+  std::chrono::steady_clock::time_point first_byte;
+  std::chrono::steady_clock::time_point last_byte;
+  std::chrono::steady_clock::time_point decoded;
+};
+} // namespace detail
+} // namespace psql
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Value types for the builtin PostgreSQL types without a standard C++ counterpart. Dates are mapped to
+// std::chrono::sys_days, and bytea to std::vector<std::byte> or std::span<const std::byte>.
+namespace psql
+{
+struct uuid
+{
+  std::array<std::byte, 16> bytes{};
+
+  // The canonical form, e.g. a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11.
+  std::string to_string() const
+  {
+    constexpr auto hex = std::string_view{ "0123456789abcdef" };
+
+    auto str = std::string{};
+    str.reserve(36);
+    for (std::size_t i = 0; i < bytes.size(); i++)
+    {
+      if (i == 4 || i == 6 || i == 8 || i == 10)
+        str += '-';
+      str += hex[std::to_integer<unsigned>(bytes[i]) >> 4];
+      str += hex[std::to_integer<unsigned>(bytes[i]) & 0xF];
+    }
+    return str;
+  }
+
+  friend bool operator==(const uuid&, const uuid&) = default;
+};
+
+// An arbitrary precision number in the representation of PostgreSQL: base-10000 digits, the power of 10000 of the
+// first digit, and the number of decimal digits after the point. It's converted to and from decimal strings on the
+// client, so the server doesn't need to cast it to text.
+struct numeric
+{
+  static constexpr uint16_t positive          = 0x0000;
+  static constexpr uint16_t negative          = 0x4000;
+  static constexpr uint16_t nan               = 0xC000;
+  static constexpr uint16_t positive_infinity = 0xD000;
+  static constexpr uint16_t negative_infinity = 0xF000;
+
+  int16_t weight{};
+  uint16_t sign{};
+  uint16_t dscale{};
+  std::vector<int16_t> digits;
+
+  // Throws std::invalid_argument if the string is not a plain decimal number, NaN, Infinity or -Infinity.
+  static numeric from_string(std::string_view str)
+  {
+    auto value = numeric{};
+
+    if (str == "NaN" || str == "Infinity" || str == "-Infinity")
+    {
+      value.sign = str == "NaN" ? nan : str == "Infinity" ? positive_infinity : negative_infinity;
+      return value;
+    }
+
+    if (!str.empty() && (str.front() == '-' || str.front() == '+'))
+    {
+      value.sign = str.front() == '-' ? negative : positive;
+      str.remove_prefix(1);
+    }
+
+    const auto point    = str.find('.');
+    const auto integral = str.substr(0, point);
+    const auto fraction = point == std::string_view::npos ? std::string_view{} : str.substr(point + 1);
+
+    if (integral.empty() && fraction.empty())
+      throw std::invalid_argument{ "Invalid numeric value" };
+
+    const auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+    for (auto part : { integral, fraction })
+    {
+      for (char c : part)
+      {
+        if (!is_digit(c))
+          throw std::invalid_argument{ "Invalid numeric value" };
+      }
+    }
+
+    // Both parts are padded with zeros to whole base-10000 digits, from the decimal point outwards.
+    const auto integral_padding = (4 - integral.size() % 4) % 4;
+    auto decimal_digits         = std::string(integral_padding, '0');
+    decimal_digits.append(integral).append(fraction).append((4 - fraction.size() % 4) % 4, '0');
+
+    value.weight = static_cast<int16_t>((integral.size() + integral_padding) / 4 - 1);
+    value.dscale = static_cast<uint16_t>(fraction.size());
+
+    for (std::size_t i = 0; i < decimal_digits.size(); i += 4)
+      value.digits.push_back(static_cast<int16_t>(std::stoi(decimal_digits.substr(i, 4))));
+
+    while (!value.digits.empty() && value.digits.back() == 0)
+      value.digits.pop_back();
+
+    auto leading_zeros = std::size_t{};
+    while (leading_zeros < value.digits.size() && value.digits[leading_zeros] == 0)
+      leading_zeros++;
+    value.digits.erase(value.digits.begin(), value.digits.begin() + leading_zeros);
+    value.weight = static_cast<int16_t>(value.weight - leading_zeros);
+
+    if (value.digits.empty())
+    {
+      value.weight = 0;
+      value.sign   = positive;
+    }
+
+    return value;
+  }
+
+  // The same decimal representation PostgreSQL produces, with dscale digits after the point.
+  std::string to_string() const
+  {
+    switch (sign)
+    {
+      case nan:
+        return "NaN";
+      case positive_infinity:
+        return "Infinity";
+      case negative_infinity:
+        return "-Infinity";
+    }
+
+    auto str = std::string{ sign == negative ? "-" : "" };
+
+    if (weight < 0)
+      str += '0';
+
+    for (int power = weight; power >= 0; power--)
+    {
+      const auto digit = std::to_string(digit_at(power));
+      if (power != weight)
+        str.append(4 - digit.size(), '0');
+      str += digit;
+    }
+
+    if (dscale > 0)
+    {
+      str += '.';
+      const auto point = str.size();
+      for (int power = -1; str.size() - point < dscale; power--)
+      {
+        const auto digit = std::to_string(digit_at(power));
+        str.append(4 - digit.size(), '0').append(digit);
+      }
+      str.resize(point + dscale);
+    }
+
+    return str;
+  }
+
+  double to_double() const
+  {
+    switch (sign)
+    {
+      case nan:
+        return std::nan("");
+      case positive_infinity:
+        return HUGE_VAL;
+      case negative_infinity:
+        return -HUGE_VAL;
+    }
+
+    auto value = 0.0;
+    for (std::size_t i = 0; i < digits.size(); i++)
+      value += digits[i] * std::pow(10000.0, weight - static_cast<int>(i));
+    return sign == negative ? -value : value;
+  }
+
+  friend bool operator==(const numeric&, const numeric&) = default;
+
+private:
+  int16_t digit_at(int power) const noexcept
+  {
+    const auto index = weight - power;
+    return index >= 0 && index < static_cast<int>(digits.size()) ? digits[index] : 0;
+  }
+};
+
+// The text of a jsonb value, which refers to the memory of the result it was deserialized from.
+struct jsonb_view
+{
+  std::string_view json;
+
+  friend bool operator==(const jsonb_view&, const jsonb_view&) = default;
+};
+
+struct interval
+{
+  std::chrono::microseconds time{};
+  int32_t days{};
+  int32_t months{};
+
+  friend bool operator==(const interval&, const interval&) = default;
+};
+
+// A timestamp with time zone. The server converts it to and from UTC, unlike a plain timestamp, which is mapped to
+// std::chrono::system_clock::time_point.
+struct timestamptz
+{
+  std::chrono::system_clock::time_point time{};
+
+  friend bool operator==(const timestamptz&, const timestamptz&) = default;
+};
+} // namespace psql